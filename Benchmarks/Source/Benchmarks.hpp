@@ -0,0 +1,51 @@
+#pragma once
+
+// std
+#include <chrono>
+#include <cstdint>
+
+namespace VoxelEngine::Benchmarks
+{
+    void runChunkStorageBenchmark();
+    void runChunkMesherBenchmark();
+    void runVertexFormatBenchmark();
+    void runTlsfHeapBenchmark();
+    void runTransformBenchmark();
+    void runMeshImportBenchmark();
+
+    class Stopwatch
+    {
+    public:
+        Stopwatch() : start{std::chrono::high_resolution_clock::now()} {}
+
+        double elapsedMicroseconds() const
+        {
+            auto now = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double, std::micro>(now - start).count();
+        }
+
+    private:
+        std::chrono::high_resolution_clock::time_point start;
+    };
+
+    // xorshift32, deterministic across runs so results are comparable
+    class Random
+    {
+    public:
+        explicit Random(uint32_t seed = 0x9e3779b9u) : state{seed} {}
+
+        uint32_t next()
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+    private:
+        uint32_t state;
+    };
+
+    // Keeps the optimizer from discarding benchmark results
+    inline volatile uint64_t sink = 0;
+}
@@ -0,0 +1,132 @@
+#include "Benchmarks.hpp"
+
+#include "World/ChunkMesher.hpp"
+#include "World/TerrainGenerator.hpp"
+
+// std
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace VoxelEngine::Benchmarks
+{
+    namespace
+    {
+        constexpr int REGION_XZ = 8;
+        constexpr int REGION_Y = 3;
+        constexpr int ITERATIONS = 20;
+
+        struct Region
+        {
+            std::vector<std::unique_ptr<Chunk>> chunks;
+
+            const Chunk *at(int x, int y, int z) const
+            {
+                if (x < 0 || y < 0 || z < 0 || x >= REGION_XZ || y >= REGION_Y || z >= REGION_XZ)
+                {
+                    return nullptr;
+                }
+                return chunks[(y * REGION_XZ + z) * REGION_XZ + x].get();
+            }
+
+            ChunkMesher::Neighbours neighbours(int x, int y, int z) const
+            {
+                return {at(x + 1, y, z), at(x - 1, y, z), at(x, y + 1, z), at(x, y - 1, z), at(x, y, z + 1), at(x, y, z - 1)};
+            }
+        };
+
+        Region generateRegion()
+        {
+            TerrainGenerator generator{};
+            std::vector<BlockId> scratch;
+            Region region;
+            for (int y = 0; y < REGION_Y; y++)
+                for (int z = 0; z < REGION_XZ; z++)
+                    for (int x = 0; x < REGION_XZ; x++)
+                    {
+                        auto chunk = std::make_unique<Chunk>();
+                        generator.generate({x, y, z}, *chunk, scratch);
+                        region.chunks.push_back(std::move(chunk));
+                    }
+            return region;
+        }
+
+        void meshRegion(const char *name, const Region &region)
+        {
+            ChunkMesher mesher;
+            Model::Builder builder;
+
+            uint64_t meshedChunks = 0;
+            uint64_t totalQuads = 0;
+            size_t maxQuads = 0;
+            double quadMicroseconds = 0.0;
+            double builderMicroseconds = 0.0;
+            std::vector<double> meshTimes;
+
+            for (int it = 0; it < ITERATIONS; it++)
+            {
+                for (int y = 0; y < REGION_Y; y++)
+                    for (int z = 0; z < REGION_XZ; z++)
+                        for (int x = 0; x < REGION_XZ; x++)
+                        {
+                            const Chunk &chunk = *region.at(x, y, z);
+                            if (chunk.isEmpty())
+                            {
+                                continue;
+                            }
+
+                            Stopwatch quadStopwatch;
+                            mesher.generateQuads(chunk, region.neighbours(x, y, z));
+                            const double quadTime = quadStopwatch.elapsedMicroseconds();
+
+                            Stopwatch builderStopwatch;
+                            mesher.mesh(chunk, region.neighbours(x, y, z), builder);
+                            const double meshTime = builderStopwatch.elapsedMicroseconds();
+
+                            quadMicroseconds += quadTime;
+                            builderMicroseconds += meshTime;
+                            meshTimes.push_back(meshTime);
+                            meshedChunks++;
+                            totalQuads += mesher.getQuads().size();
+                            maxQuads = std::max(maxQuads, mesher.getQuads().size());
+                            sink = sink + builder.indices.size();
+                        }
+            }
+
+            // The median is much less sensitive to scheduler noise than the mean
+            std::sort(meshTimes.begin(), meshTimes.end());
+            const double medianMicroseconds = meshTimes[meshTimes.size() / 2];
+
+            const double quadsPerChunk = static_cast<double>(totalQuads) / meshedChunks;
+            std::cout << name << ": " << meshedChunks / ITERATIONS << " non-empty chunks" << std::endl
+                      << std::fixed << std::setprecision(1)
+                      << "  quads/chunk      " << std::setw(8) << quadsPerChunk << " (max " << maxQuads << ")" << std::endl
+                      << "  vertex bytes     " << std::setw(8) << quadsPerChunk * 4 * sizeof(Model::Vertex) << " B/chunk" << std::endl
+                      << std::setprecision(2)
+                      << "  quads only       " << std::setw(8) << quadMicroseconds / meshedChunks << " us/chunk" << std::endl
+                      << "  with builder     " << std::setw(8) << builderMicroseconds / meshedChunks << " us/chunk"
+                      << " (median " << medianMicroseconds << " us, target < 100 us)" << std::endl;
+        }
+    }
+
+    void runChunkMesherBenchmark()
+    {
+        meshRegion("terrain", generateRegion());
+
+        // Worst case for greedy merging: every other voxel solid, surrounded by empty chunks
+        Region checkerboard;
+        for (int i = 0; i < REGION_XZ * REGION_XZ * REGION_Y; i++)
+        {
+            checkerboard.chunks.push_back(std::make_unique<Chunk>());
+        }
+        Chunk &first = *checkerboard.chunks[0];
+        for (int y = 0; y < Chunk::SIZE; y++)
+            for (int z = 0; z < Chunk::SIZE; z++)
+                for (int x = 0; x < Chunk::SIZE; x++)
+                    if (((x + y + z) & 1) == 0)
+                        first.set(x, y, z, Blocks::STONE);
+        meshRegion("checkerboard", checkerboard);
+    }
+}
@@ -0,0 +1,148 @@
+#include "Benchmarks.hpp"
+
+#include "World/Chunk.hpp"
+
+// std
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace VoxelEngine::Benchmarks
+{
+    namespace
+    {
+        constexpr int ITERATIONS = 32;
+
+        std::unique_ptr<Chunk> makeLayeredChunk()
+        {
+            // Stone bottom, a few dirt layers, grass top and air above
+            auto chunk = std::make_unique<Chunk>();
+            chunk->fill({0, 0, 0}, {Chunk::SIZE, 12, Chunk::SIZE}, 1);
+            chunk->fill({0, 12, 0}, {Chunk::SIZE, 15, Chunk::SIZE}, 2);
+            chunk->fill({0, 15, 0}, {Chunk::SIZE, 16, Chunk::SIZE}, 3);
+            return chunk;
+        }
+
+        std::unique_ptr<Chunk> makeRandomChunk(uint32_t blockTypes)
+        {
+            auto chunk = std::make_unique<Chunk>();
+            Random random{blockTypes};
+            for (int i = 0; i < Chunk::VOLUME; i++)
+            {
+                chunk->setIndex(i, static_cast<BlockId>(random.next() % blockTypes));
+            }
+            return chunk;
+        }
+
+        void reportMemory(const std::string &name, const Chunk &chunk)
+        {
+            const size_t bytes = chunk.getMemoryUsage();
+            const double perMillionGiB = bytes * 1'000'000.0 / (1024.0 * 1024.0 * 1024.0);
+            std::cout << std::left << std::setw(22) << name << std::right
+                      << " bits " << std::setw(2) << chunk.getBitsPerIndex()
+                      << "  palette " << std::setw(4) << chunk.getPaletteSize()
+                      << "  " << std::setw(6) << bytes << " B/chunk"
+                      << "  " << std::fixed << std::setprecision(2) << std::setw(7) << perMillionGiB
+                      << " GiB per 1M chunks" << std::endl;
+        }
+
+        void reportTiming(const std::string &name, double microseconds, uint64_t operations)
+        {
+            std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(8) << microseconds * 1000.0 / operations << " ns/op" << std::endl;
+        }
+
+        void benchmarkAccess(const std::string &name, Chunk &chunk)
+        {
+            std::cout << name << " (" << chunk.getBitsPerIndex() << " bits/voxel)" << std::endl;
+            const uint64_t operations = uint64_t{ITERATIONS} * Chunk::VOLUME;
+
+            // Pre-generate indices so the RNG is not part of the measurement
+            std::vector<int> randomIndices(Chunk::VOLUME);
+            Random random{};
+            for (int &index : randomIndices)
+            {
+                index = static_cast<int>(random.next() % Chunk::VOLUME);
+            }
+
+            uint64_t checksum = 0;
+            {
+                Stopwatch stopwatch;
+                for (int it = 0; it < ITERATIONS; it++)
+                    for (int y = 0; y < Chunk::SIZE; y++)
+                        for (int z = 0; z < Chunk::SIZE; z++)
+                            for (int x = 0; x < Chunk::SIZE; x++)
+                                checksum += chunk.get(x, y, z);
+                reportTiming("  linear get", stopwatch.elapsedMicroseconds(), operations);
+            }
+            {
+                Stopwatch stopwatch;
+                for (int it = 0; it < ITERATIONS; it++)
+                    for (int index : randomIndices)
+                        checksum += chunk.getIndex(index);
+                reportTiming("  random get", stopwatch.elapsedMicroseconds(), operations);
+            }
+            {
+                std::vector<BlockId> voxels(Chunk::VOLUME);
+                Stopwatch stopwatch;
+                for (int it = 0; it < ITERATIONS; it++)
+                {
+                    chunk.decode(voxels.data());
+                    checksum += voxels[it];
+                }
+                reportTiming("  decode", stopwatch.elapsedMicroseconds(), operations);
+            }
+            {
+                // Rewrites existing values so the palette layout does not change under us
+                std::vector<BlockId> voxels(Chunk::VOLUME);
+                chunk.decode(voxels.data());
+                Stopwatch stopwatch;
+                for (int it = 0; it < ITERATIONS; it++)
+                    for (int i = 0; i < Chunk::VOLUME; i++)
+                        chunk.setIndex(i, voxels[Chunk::VOLUME - 1 - i]);
+                reportTiming("  linear set", stopwatch.elapsedMicroseconds(), operations);
+            }
+            {
+                std::vector<BlockId> voxels(Chunk::VOLUME);
+                chunk.decode(voxels.data());
+                Stopwatch stopwatch;
+                for (int it = 0; it < ITERATIONS; it++)
+                    for (int index : randomIndices)
+                        chunk.setIndex(index, voxels[(index * 7) % Chunk::VOLUME]);
+                reportTiming("  random set", stopwatch.elapsedMicroseconds(), operations);
+            }
+
+            sink = sink + checksum;
+        }
+    }
+
+    void runChunkStorageBenchmark()
+    {
+        std::cout << "uncompressed: " << Chunk::VOLUME * sizeof(BlockId) << " B/chunk" << std::endl;
+
+        Chunk air{};
+        Chunk stone{1};
+        Chunk mostlyAir{};
+        mostlyAir.set(3, 4, 5, 1);
+        mostlyAir.set(20, 7, 11, 1);
+        auto layered = makeLayeredChunk();
+        auto random4 = makeRandomChunk(4);
+        auto random16 = makeRandomChunk(16);
+        auto random300 = makeRandomChunk(300);
+
+        reportMemory("air", air);
+        reportMemory("stone", stone);
+        reportMemory("mostly air", mostlyAir);
+        reportMemory("layered terrain", *layered);
+        reportMemory("random 4 types", *random4);
+        reportMemory("random 16 types", *random16);
+        reportMemory("random 300 types", *random300);
+        std::cout << std::endl;
+
+        benchmarkAccess("layered terrain", *layered);
+        benchmarkAccess("random 16 types", *random16);
+        benchmarkAccess("random 300 types", *random300);
+    }
+}
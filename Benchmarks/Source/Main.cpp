@@ -0,0 +1,53 @@
+#include "Benchmarks.hpp"
+
+// std
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace VoxelEngine::Benchmarks;
+
+int main(int argc, char **argv)
+{
+    const std::vector<std::pair<std::string, void (*)()>> benchmarks = {
+        {"chunk-storage", runChunkStorageBenchmark},
+        {"chunk-mesher", runChunkMesherBenchmark},
+        {"vertex-format", runVertexFormatBenchmark},
+        {"tlsf-heap", runTlsfHeapBenchmark},
+        {"transform", runTransformBenchmark},
+        {"mesh-import", runMeshImportBenchmark},
+    };
+
+    // Runs every benchmark, or only the ones named on the command line
+    bool ranAny = false;
+    for (const auto &[name, run] : benchmarks)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++)
+        {
+            selected |= name == argv[i];
+        }
+
+        if (selected)
+        {
+            std::cout << "== " << name << " ==" << std::endl;
+            run();
+            std::cout << std::endl;
+            ranAny = true;
+        }
+    }
+
+    if (!ranAny)
+    {
+        std::cerr << "available benchmarks:" << std::endl;
+        for (const auto &benchmark : benchmarks)
+        {
+            std::cerr << "\t" << benchmark.first << std::endl;
+        }
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+#include "Benchmarks.hpp"
+
+#include "Platform/Model.hpp"
+#include "Utils/Utils.hpp"
+
+// libs
+#include <tiny_obj_loader.h>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+// std
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef VOXEL_ENGINE_MODEL_DIRECTORY
+#define VOXEL_ENGINE_MODEL_DIRECTORY "../../Game/Resources/Models"
+#endif
+
+namespace VoxelEngine::Benchmarks
+{
+    namespace
+    {
+        constexpr int ITERATIONS = 20;
+        const char *MODELS[] = {"colored_cube.obj", "flat_vase.obj", "smooth_vase.obj"};
+
+        struct VertexHash
+        {
+            size_t operator()(const Model::Vertex &vertex) const
+            {
+                size_t seed = 0;
+                hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+                return seed;
+            }
+        };
+
+        bool parse(const std::string &path, tinyobj::attrib_t &attrib, std::vector<tinyobj::shape_t> &shapes)
+        {
+            std::vector<tinyobj::material_t> materials;
+            std::string warn, err;
+            return tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str());
+        }
+
+        // What Builder::loadModel did before: the whole vertex hashed into a std::unordered_map
+        void dedupLegacy(const tinyobj::attrib_t &attrib, const std::vector<tinyobj::shape_t> &shapes,
+                         std::vector<Model::Vertex> &vertices, std::vector<uint32_t> &indices)
+        {
+            std::unordered_map<Model::Vertex, uint32_t, VertexHash> uniqueVertices{};
+            for (const auto &shape : shapes)
+            {
+                for (const auto &index : shape.mesh.indices)
+                {
+                    Model::Vertex vertex{};
+                    if (index.vertex_index >= 0)
+                    {
+                        vertex.position = {attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1], attrib.vertices[3 * index.vertex_index + 2]};
+                        vertex.color = {attrib.colors[3 * index.vertex_index + 0], attrib.colors[3 * index.vertex_index + 1], attrib.colors[3 * index.vertex_index + 2]};
+                    }
+                    if (index.normal_index >= 0)
+                    {
+                        vertex.normal = {attrib.normals[3 * index.normal_index + 0], attrib.normals[3 * index.normal_index + 1], attrib.normals[3 * index.normal_index + 2]};
+                    }
+                    if (index.texcoord_index >= 0)
+                    {
+                        vertex.uv = {attrib.texcoords[2 * index.texcoord_index + 0], attrib.texcoords[2 * index.texcoord_index + 1]};
+                    }
+
+                    if (uniqueVertices.count(vertex) == 0)
+                    {
+                        uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+                        vertices.push_back(vertex);
+                    }
+                    indices.push_back(uniqueVertices[vertex]);
+                }
+            }
+        }
+
+        // Both loaders must describe the same triangles, whatever the vertex numbering
+        bool sameTriangles(const std::vector<Model::Vertex> &vertices, const std::vector<uint32_t> &indices, const Model::Builder &builder)
+        {
+            if (indices.size() != builder.indices.size())
+            {
+                return false;
+            }
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                if (!(vertices[indices[i]] == builder.vertices[builder.indices[i]]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    void runMeshImportBenchmark()
+    {
+        std::cout << std::fixed << std::setprecision(1);
+        for (const char *name : MODELS)
+        {
+            const std::string path = std::string{VOXEL_ENGINE_MODEL_DIRECTORY} + "/" + name;
+
+            tinyobj::attrib_t attrib;
+            std::vector<tinyobj::shape_t> shapes;
+            if (!parse(path, attrib, shapes))
+            {
+                std::cout << name << ": not found under " << VOXEL_ENGINE_MODEL_DIRECTORY << std::endl;
+                continue;
+            }
+
+            double parseUs = 0.0;
+            for (int iteration = 0; iteration < ITERATIONS; iteration++)
+            {
+                Stopwatch stopwatch{};
+                tinyobj::attrib_t parsedAttrib;
+                std::vector<tinyobj::shape_t> parsedShapes;
+                parse(path, parsedAttrib, parsedShapes);
+                parseUs += stopwatch.elapsedMicroseconds() / ITERATIONS;
+                sink = sink + parsedShapes.size();
+            }
+
+            // Deduplication alone, on the same parsed data
+            double legacyUs = 0.0, serialUs = 0.0, parallelUs = 0.0;
+            std::vector<Model::Vertex> legacyVertices;
+            std::vector<uint32_t> legacyIndices;
+            Model::Builder serial{};
+            Model::Builder parallel{};
+            for (int iteration = 0; iteration < ITERATIONS; iteration++)
+            {
+                {
+                    legacyVertices.clear();
+                    legacyIndices.clear();
+                    Stopwatch stopwatch{};
+                    dedupLegacy(attrib, shapes, legacyVertices, legacyIndices);
+                    legacyUs += stopwatch.elapsedMicroseconds() / ITERATIONS;
+                }
+                {
+                    Stopwatch stopwatch{};
+                    serial.loadShapes(attrib, shapes);
+                    serialUs += stopwatch.elapsedMicroseconds() / ITERATIONS;
+                }
+                {
+                    Stopwatch stopwatch{};
+                    parallel.loadShapes(attrib, shapes, true);
+                    parallelUs += stopwatch.elapsedMicroseconds() / ITERATIONS;
+                }
+            }
+
+            const bool valid = sameTriangles(legacyVertices, legacyIndices, serial) && sameTriangles(legacyVertices, legacyIndices, parallel);
+            std::cout << name << " (" << shapes.size() << " shapes, " << legacyIndices.size() << " indices)" << std::endl;
+            std::cout << "  parse:                " << parseUs << " us" << std::endl;
+            std::cout << "  unordered_map<Vertex>: " << legacyUs << " us, " << legacyVertices.size() << " vertices" << std::endl;
+            std::cout << "  triplet map:          " << serialUs << " us, " << serial.vertices.size() << " vertices" << std::endl;
+            std::cout << "  triplet map, shapes:  " << parallelUs << " us, " << parallel.vertices.size() << " vertices" << std::endl;
+            std::cout << "  same triangles: " << (valid ? "yes" : "NO") << std::endl;
+        }
+    }
+}
@@ -0,0 +1,177 @@
+#include "Benchmarks.hpp"
+
+#include "Utils/TlsfHeap.hpp"
+
+// std
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace VoxelEngine::Benchmarks
+{
+    namespace
+    {
+        constexpr uint64_t HEAP_SIZE = 64ull * 1024 * 1024;
+        constexpr uint64_t ALIGNMENT = 256;
+        constexpr int OPERATIONS = 200000;
+        // Roughly a streamed world's worth of chunk vertex and index buffers
+        constexpr size_t TARGET_LIVE = 600;
+
+        // What a straightforward allocator would do: first fit over an offset-ordered free map
+        class FirstFitHeap
+        {
+        public:
+            explicit FirstFitHeap(uint64_t size) { freeRanges[0] = size; }
+
+            bool allocate(uint64_t size, uint64_t alignment, uint64_t &offset)
+            {
+                for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+                {
+                    const uint64_t aligned = (it->first + alignment - 1) & ~(alignment - 1);
+                    if (aligned + size > it->first + it->second)
+                        continue;
+
+                    const uint64_t start = it->first;
+                    const uint64_t end = it->first + it->second;
+                    freeRanges.erase(it);
+                    if (aligned > start)
+                        freeRanges[start] = aligned - start;
+                    if (aligned + size < end)
+                        freeRanges[aligned + size] = end - aligned - size;
+                    offset = aligned;
+                    return true;
+                }
+                return false;
+            }
+
+            void free(uint64_t offset, uint64_t size)
+            {
+                auto it = freeRanges.emplace(offset, size).first;
+                auto next = std::next(it);
+                if (next != freeRanges.end() && it->first + it->second == next->first)
+                {
+                    it->second += next->second;
+                    freeRanges.erase(next);
+                }
+                if (it != freeRanges.begin())
+                {
+                    auto prev = std::prev(it);
+                    if (prev->first + prev->second == it->first)
+                    {
+                        prev->second += it->second;
+                        freeRanges.erase(it);
+                    }
+                }
+            }
+
+            size_t getFreeRangeCount() const { return freeRanges.size(); }
+
+        private:
+            std::map<uint64_t, uint64_t> freeRanges;
+        };
+
+        struct Live
+        {
+            uint64_t offset;
+            uint64_t size;
+            uint32_t node;
+        };
+
+        uint64_t nextSize(Random &random)
+        {
+            // Mostly small meshes with the occasional dense one, 1 KiB to 256 KiB
+            const uint32_t roll = random.next() % 100;
+            const uint64_t limit = roll < 80 ? 32 * 1024 : 256 * 1024;
+            return 1024 + random.next() % limit;
+        }
+
+        template <typename Allocate, typename Free>
+        double churn(Allocate &&allocate, Free &&free, uint64_t &failures)
+        {
+            Random random{};
+            std::vector<Live> live;
+            live.reserve(TARGET_LIVE * 2);
+            failures = 0;
+
+            Stopwatch stopwatch{};
+            for (int i = 0; i < OPERATIONS; i++)
+            {
+                const bool release = !live.empty() && (live.size() >= TARGET_LIVE * 2 || random.next() % (2 * TARGET_LIVE) < live.size());
+                if (release)
+                {
+                    const size_t index = random.next() % live.size();
+                    free(live[index]);
+                    live[index] = live.back();
+                    live.pop_back();
+                    continue;
+                }
+
+                Live allocation{0, nextSize(random), 0};
+                if (allocate(allocation))
+                    live.push_back(allocation);
+                else
+                    failures++;
+            }
+            const double elapsed = stopwatch.elapsedMicroseconds();
+
+            for (auto &allocation : live)
+                free(allocation);
+            return elapsed * 1000.0 / OPERATIONS;
+        }
+    }
+
+    void runTlsfHeapBenchmark()
+    {
+        TlsfHeap tlsf{HEAP_SIZE};
+        uint64_t tlsfFailures = 0;
+        const double tlsfNs = churn(
+            [&](Live &allocation)
+            {
+                allocation.node = tlsf.allocate(allocation.size, ALIGNMENT, allocation.offset);
+                return allocation.node != TlsfHeap::INVALID_NODE;
+            },
+            [&](Live &allocation) { tlsf.free(allocation.node); },
+            tlsfFailures);
+
+        FirstFitHeap firstFit{HEAP_SIZE};
+        uint64_t firstFitFailures = 0;
+        const double firstFitNs = churn(
+            [&](Live &allocation) { return firstFit.allocate(allocation.size, ALIGNMENT, allocation.offset); },
+            [&](Live &allocation) { firstFit.free(allocation.offset, allocation.size); },
+            firstFitFailures);
+
+        // Fragmentation snapshot with the heap about half full
+        TlsfHeap snapshot{HEAP_SIZE};
+        Random random{42};
+        std::vector<uint32_t> nodes;
+        uint64_t offset;
+        while (snapshot.getUsedBytes() < HEAP_SIZE * 3 / 4)
+        {
+            const uint32_t node = snapshot.allocate(nextSize(random), ALIGNMENT, offset);
+            if (node == TlsfHeap::INVALID_NODE)
+                break;
+            nodes.push_back(node);
+        }
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            if (random.next() % 3 == 0)
+                snapshot.free(nodes[i]);
+        }
+        const double freeBytes = static_cast<double>(snapshot.getFreeBytes());
+        const double fragmentation = 1.0 - static_cast<double>(snapshot.getLargestFreeRange()) / freeBytes;
+
+        std::cout << OPERATIONS << " mixed operations, ~" << TARGET_LIVE << " live ranges in a "
+                  << HEAP_SIZE / (1024 * 1024) << " MiB block" << std::endl
+                  << std::fixed << std::setprecision(1)
+                  << "  TlsfHeap    " << std::setw(8) << tlsfNs << " ns/op  " << tlsfFailures << " failed" << std::endl
+                  << "  first fit   " << std::setw(8) << firstFitNs << " ns/op  " << firstFitFailures << " failed  ("
+                  << firstFit.getFreeRangeCount() << " free ranges left)" << std::endl
+                  << std::setprecision(3)
+                  << "  after random frees: " << snapshot.getAllocationCount() << " live, fragmentation " << fragmentation << std::endl;
+
+        sink = sink + tlsf.getUsedBytes() + snapshot.getUsedBytes();
+    }
+}
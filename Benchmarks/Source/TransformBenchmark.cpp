@@ -0,0 +1,125 @@
+#include "Benchmarks.hpp"
+
+#include "Core/TransformPool.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace VoxelEngine::Benchmarks
+{
+    namespace
+    {
+        constexpr uint32_t OBJECT_COUNT = 100000;
+        constexpr int ITERATIONS = 50;
+        // A mostly static scene with a few things moving
+        constexpr uint32_t MOVING_PERCENT = 1;
+
+        float nextFloat(Random &random, float min, float max)
+        {
+            return min + (max - min) * static_cast<float>(random.next() % 65536) / 65535.f;
+        }
+
+        TransformComponent nextTransform(Random &random)
+        {
+            TransformComponent transform{};
+            transform.translation = {nextFloat(random, -500.f, 500.f), nextFloat(random, -50.f, 50.f), nextFloat(random, -500.f, 500.f)};
+            transform.rotation = {nextFloat(random, -6.3f, 6.3f), nextFloat(random, -6.3f, 6.3f), nextFloat(random, -6.3f, 6.3f)};
+            transform.scale = {nextFloat(random, 0.25f, 4.f), nextFloat(random, 0.25f, 4.f), nextFloat(random, 0.25f, 4.f)};
+            return transform;
+        }
+
+        float maxDifference(const glm::mat4 &a, const glm::mat4 &b)
+        {
+            float difference = 0.f;
+            for (int column = 0; column < 4; column++)
+                for (int row = 0; row < 4; row++)
+                    difference = std::max(difference, std::abs(a[column][row] - b[column][row]));
+            return difference;
+        }
+    }
+
+    void runTransformBenchmark()
+    {
+        Random random{};
+        std::vector<TransformComponent> transforms(OBJECT_COUNT);
+        for (auto &transform : transforms)
+            transform = nextTransform(random);
+
+        TransformPool pool{};
+        std::vector<TransformPool::Handle> handles(OBJECT_COUNT);
+        for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+            handles[i] = pool.create(transforms[i]);
+        pool.updateMatrices();
+
+        // What renderGameObjects did before: both matrices from scratch for every object
+        double perObjectUs = 0.0;
+        for (int iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+            float checksum = 0.f;
+            Stopwatch stopwatch{};
+            for (auto &transform : transforms)
+            {
+                const glm::mat4 model = transform.mat4();
+                const glm::mat4 normal{transform.normalMatrix()};
+                checksum += model[3][0] + normal[1][1];
+            }
+            perObjectUs += stopwatch.elapsedMicroseconds();
+            sink = sink + static_cast<uint64_t>(checksum != 0.f);
+        }
+
+        double allDirtyUs = 0.0;
+        for (int iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+            for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+                pool.set(handles[i], transforms[i]);
+
+            Stopwatch stopwatch{};
+            pool.updateMatrices();
+            allDirtyUs += stopwatch.elapsedMicroseconds();
+        }
+
+        double fewDirtyUs = 0.0;
+        for (int iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+            for (uint32_t i = 0; i < OBJECT_COUNT * MOVING_PERCENT / 100; i++)
+            {
+                const uint32_t index = random.next() % OBJECT_COUNT;
+                transforms[index].rotation.y += 0.01f;
+                pool.setRotation(handles[index], transforms[index].rotation);
+            }
+
+            Stopwatch stopwatch{};
+            pool.updateMatrices();
+            fewDirtyUs += stopwatch.elapsedMicroseconds();
+        }
+
+        double cleanUs = 0.0;
+        for (int iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+            Stopwatch stopwatch{};
+            pool.updateMatrices();
+            cleanUs += stopwatch.elapsedMicroseconds();
+        }
+
+        float worldError = 0.f;
+        float normalError = 0.f;
+        for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+        {
+            worldError = std::max(worldError, maxDifference(pool.getWorldMatrix(handles[i]), transforms[i].mat4()));
+            normalError = std::max(normalError, maxDifference(pool.getNormalMatrix(handles[i]), glm::mat4{transforms[i].normalMatrix()}));
+        }
+
+        std::cout << OBJECT_COUNT << " transforms, model + normal matrix, average of " << ITERATIONS << " frames" << std::endl
+                  << std::fixed << std::setprecision(1)
+                  << "  per object mat4()       " << std::setw(9) << perObjectUs / ITERATIONS << " us" << std::endl
+                  << "  TransformPool all dirty " << std::setw(9) << allDirtyUs / ITERATIONS << " us" << std::endl
+                  << "  TransformPool " << MOVING_PERCENT << "% dirty  " << std::setw(9) << fewDirtyUs / ITERATIONS << " us" << std::endl
+                  << "  TransformPool clean     " << std::setw(9) << cleanUs / ITERATIONS << " us" << std::endl
+                  << std::scientific << std::setprecision(2)
+                  << "  max error vs mat4(): world " << worldError << ", normal " << normalError << std::endl;
+    }
+}
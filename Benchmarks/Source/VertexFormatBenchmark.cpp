@@ -0,0 +1,98 @@
+#include "Benchmarks.hpp"
+
+#include "World/ChunkMesher.hpp"
+#include "World/TerrainGenerator.hpp"
+
+// std
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace VoxelEngine::Benchmarks
+{
+    namespace
+    {
+        constexpr int RADIUS = 16;
+        constexpr int DIAMETER = RADIUS * 2 + 1;
+        // Terrain never reaches the third chunk layer
+        constexpr int CHUNKS_Y = 2;
+
+        double toMiB(double bytes) { return bytes / (1024.0 * 1024.0); }
+    }
+
+    void runVertexFormatBenchmark()
+    {
+        TerrainGenerator generator{};
+        std::vector<Chunk> chunks(DIAMETER * DIAMETER * CHUNKS_Y);
+        auto chunkAt = [](int x, int y, int z) { return (y * DIAMETER + z) * DIAMETER + x; };
+        auto inRadius = [](int x, int z) { return (x - RADIUS) * (x - RADIUS) + (z - RADIUS) * (z - RADIUS) <= RADIUS * RADIUS; };
+
+        std::vector<BlockId> scratch;
+        for (int y = 0; y < CHUNKS_Y; y++)
+            for (int z = 0; z < DIAMETER; z++)
+                for (int x = 0; x < DIAMETER; x++)
+                    if (inRadius(x, z))
+                        generator.generate({x - RADIUS, y, z - RADIUS}, chunks[chunkAt(x, y, z)], scratch);
+
+        auto neighbour = [&](int x, int y, int z) -> const Chunk *
+        {
+            if (x < 0 || y < 0 || z < 0 || x >= DIAMETER || y >= CHUNKS_Y || z >= DIAMETER || !inRadius(x, z))
+                return nullptr;
+            return &chunks[chunkAt(x, y, z)];
+        };
+
+        ChunkMesher mesher;
+        Model::Builder standard{};
+        Model::Builder packed{};
+        packed.vertexFormat = Model::VertexFormat::Packed;
+
+        uint64_t chunkCount = 0;
+        uint64_t meshCount = 0;
+        uint64_t standardBytes = 0;
+        uint64_t packedBytes = 0;
+        uint64_t indexBytes = 0;
+        uint64_t mismatches = 0;
+        for (int y = 0; y < CHUNKS_Y; y++)
+            for (int z = 0; z < DIAMETER; z++)
+                for (int x = 0; x < DIAMETER; x++)
+                {
+                    if (!inRadius(x, z))
+                        continue;
+                    chunkCount++;
+
+                    const Chunk &chunk = chunks[chunkAt(x, y, z)];
+                    const ChunkMesher::Neighbours neighbours = {
+                        neighbour(x + 1, y, z), neighbour(x - 1, y, z), neighbour(x, y + 1, z),
+                        neighbour(x, y - 1, z), neighbour(x, y, z + 1), neighbour(x, y, z - 1)};
+                    mesher.mesh(chunk, neighbours, standard);
+                    mesher.mesh(chunk, neighbours, packed);
+                    if (standard.indices.empty())
+                        continue;
+                    meshCount++;
+
+                    standardBytes += standard.vertices.size() * sizeof(Model::Vertex);
+                    packedBytes += packed.packedVertices.size() * sizeof(Model::PackedVertex);
+                    indexBytes += standard.indices.size() * sizeof(uint32_t);
+
+                    // Both formats must describe the same corners
+                    for (size_t i = 0; i < standard.vertices.size(); i++)
+                    {
+                        if (glm::vec3{packed.packedVertices[i].getPosition()} != standard.vertices[i].position)
+                            mismatches++;
+                    }
+                }
+
+        std::cout << "world radius " << RADIUS << " chunks: " << chunkCount << " chunks, " << meshCount << " with geometry" << std::endl
+                  << std::fixed << std::setprecision(2)
+                  << "  Model::Vertex       " << std::setw(3) << sizeof(Model::Vertex) << " B/vertex  "
+                  << std::setw(8) << toMiB(standardBytes) << " MiB vertices  "
+                  << std::setw(8) << toMiB(standardBytes + indexBytes) << " MiB with indices" << std::endl
+                  << "  Model::PackedVertex " << std::setw(3) << sizeof(Model::PackedVertex) << " B/vertex  "
+                  << std::setw(8) << toMiB(packedBytes) << " MiB vertices  "
+                  << std::setw(8) << toMiB(packedBytes + indexBytes) << " MiB with indices" << std::endl
+                  << "  vertex memory ratio " << static_cast<double>(standardBytes) / packedBytes << "x" << std::endl
+                  << "  position mismatches " << mismatches << std::endl;
+
+        sink = sink + standardBytes + packedBytes;
+    }
+}
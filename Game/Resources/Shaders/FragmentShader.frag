@@ -5,11 +5,6 @@ layout(location = 1) in vec2 fragUV;
 
 layout (location = 0) out vec4 outColor;
 
-layout(push_constant) uniform Push {
-    mat4 modelMatrix;
-    mat4 normalMatrix;
-} push;
-
 layout(set = 0, binding = 1) uniform sampler2D image;
 
 void main()
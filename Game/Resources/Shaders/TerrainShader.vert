@@ -0,0 +1,51 @@
+#version 450
+
+// Model::PackedVertex
+//   data.x: x:6 y:6 z:6 face:3 ao:2
+//   data.y: texture layer:16 tint:16 (RGB565)
+layout(location = 0) in uvec2 data;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUV;
+
+layout(set = 0, binding = 0) uniform GlobalUniformBuffer {
+    mat4 projectionViewMatrix;
+    vec3 directionToLight;
+} uniformBuffer;
+
+// TerrainRenderSystem::ChunkDrawData, indexed by the draw's firstInstance
+layout(std430, set = 1, binding = 0) readonly buffer ChunkDraws {
+    vec4 origins[];
+} chunkDraws;
+
+const float AMBIENT = 0.02;
+const float AO_STRENGTH = 0.2;
+
+// Same order as ChunkMesher::Face
+const vec3 FACE_NORMALS[6] = vec3[](
+    vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0),
+    vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0),
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0));
+
+// Chunks are y-up, the world is y-down (ChunkManager::getModelMatrix)
+const vec3 FLIP_Y = vec3(1.0, -1.0, 1.0);
+
+void main()
+{
+    vec3 position = vec3(data.x & 63u, (data.x >> 6) & 63u, (data.x >> 12) & 63u);
+    uint face = (data.x >> 18) & 7u;
+    float ao = float((data.x >> 21) & 3u);
+    vec3 tint = vec3((data.y >> 16) & 31u, (data.y >> 21) & 63u, (data.y >> 27) & 31u) / vec3(31.0, 63.0, 31.0);
+
+    vec3 worldPosition = (chunkDraws.origins[gl_InstanceIndex].xyz + position) * FLIP_Y;
+    gl_Position = uniformBuffer.projectionViewMatrix * vec4(worldPosition, 1.0);
+
+    vec3 normalWorldSpace = FACE_NORMALS[face] * FLIP_Y;
+    float lightIntensity = AMBIENT + max(dot(normalWorldSpace, uniformBuffer.directionToLight), 0);
+
+    fragColor = lightIntensity * (1.0 - AO_STRENGTH * ao) * tint;
+
+    // Tile the texture once per voxel across the face plane, column then row as in the mesher
+    uint axis = face >> 1;
+    fragUV = vec2(position[(axis + 2u) % 3u], position[(axis + 1u) % 3u]);
+}
@@ -13,29 +13,38 @@ layout(set = 0, binding = 0) uniform GlobalUniformBuffer {
     vec3 directionToLight;
 } uniformBuffer;
 
-layout(push_constant) uniform Push {
+// SimpleRenderSystem::ObjectData, indexed by the draw's firstInstance
+struct ObjectData {
     mat4 modelMatrix;
-    mat4 normalMatrix;
-} push;
+    vec4 normalMatrix[3];
+    vec4 color;
+    uint materialId;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+} objectBuffer;
 
 const float AMBIENT = 0.02;
 
 void main()
 {
-    gl_Position = uniformBuffer.projectionViewMatrix * push.modelMatrix * vec4(position, 1.0);
+    ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+    gl_Position = uniformBuffer.projectionViewMatrix * object.modelMatrix * vec4(position, 1.0);
 
     // temporally: this is only correct in certain situations
     // only works correctly if the scale is uniform (scale.x == scale.y == scale.z)
-    // vec3 normalWorldSpace = normalize(mat3(push.modelMatrix) * normal);
+    // vec3 normalWorldSpace = normalize(mat3(object.modelMatrix) * normal);
 
     // calculating the inverse in a shader can be expensive, so we use a normal matrix
-    // vec3 normalMatrix = transpose(inverse(mat3(push.modelMatrix)));
+    // vec3 normalMatrix = transpose(inverse(mat3(object.modelMatrix)));
     // vec3 normalWorldSpace = normalize(normalMatrix * normal);
 
-    vec3 normalWorldSpace = normalize(mat3(push.normalMatrix) * normal);
+    mat3 normalMatrix = mat3(object.normalMatrix[0].xyz, object.normalMatrix[1].xyz, object.normalMatrix[2].xyz);
+    vec3 normalWorldSpace = normalize(normalMatrix * normal);
 
     float lightIntensity = AMBIENT + max(dot(normalWorldSpace, uniformBuffer.directionToLight), 0);
 
-    fragColor = lightIntensity * color;
+    fragColor = lightIntensity * color * object.color.rgb;
     fragUV = uv;
 }
\ No newline at end of file
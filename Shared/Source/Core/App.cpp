@@ -6,6 +6,7 @@
 #include "Camera.hpp"
 #include "KeyboardController.hpp"
 #include "SimpleRenderSystem.hpp"
+#include "TerrainRenderSystem.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -16,11 +17,23 @@
 #include <array>
 #include <chrono>
 #include <cassert>
+#include <cstdlib>
+#include <iostream>
 #include <stdexcept>
+#include <string>
 
 namespace VoxelEngine
 {
 
+    // Terrain is y-up in chunk space and flipped into the y-down world, start above sea level
+    constexpr float SPAWN_HEIGHT = -(TerrainGenerator::SEA_LEVEL + 10.f);
+    // T cycles through these to compare record times, 0 records inline without secondary buffers
+    constexpr std::array<uint32_t, 5> RECORDING_THREAD_COUNTS = {0, 1, 2, 4, 8};
+    // P and O cycle these to compare latency, image count 0 lets the swapchain pick
+    constexpr std::array<VkPresentModeKHR, 4> PRESENT_MODES = {
+        VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    constexpr std::array<uint32_t, 4> SWAPCHAIN_IMAGE_COUNTS = {0, 2, 3, 4};
+
     struct GlobalUniformBuffer
     {
         glm::mat4 projectionView{1.f};
@@ -30,9 +43,9 @@ namespace VoxelEngine
     App::App()
     {
         globalPool = DescriptorPool::Builder(device)
-            .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .setMaxSets(renderer.getFramesInFlight())
+            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, renderer.getFramesInFlight())
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, renderer.getFramesInFlight())
             .build();
 
         loadObjects();
@@ -40,9 +53,27 @@ namespace VoxelEngine
 
     App::~App() {}
 
+    uint32_t App::getConfiguredFramesInFlight()
+    {
+        const char *value = std::getenv(FRAMES_IN_FLIGHT_VARIABLE);
+        if (value == nullptr)
+        {
+            return SwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+        }
+
+        const int framesInFlight = std::atoi(value);
+        if (framesInFlight < 1 || framesInFlight > SwapChain::MAX_FRAMES_IN_FLIGHT)
+        {
+            std::cerr << FRAMES_IN_FLIGHT_VARIABLE << " must be between 1 and " << SwapChain::MAX_FRAMES_IN_FLIGHT
+                      << ", using " << SwapChain::DEFAULT_FRAMES_IN_FLIGHT << std::endl;
+            return SwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+        }
+        return static_cast<uint32_t>(framesInFlight);
+    }
+
     void App::run()
     {
-        std::vector<std::unique_ptr<Buffer>> uniformBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        std::vector<std::unique_ptr<Buffer>> uniformBuffers(renderer.getFramesInFlight());
         for (int i = 0; i < uniformBuffers.size(); i++)
         {
             uniformBuffers[i] = std::make_unique<Buffer>(
@@ -59,14 +90,14 @@ namespace VoxelEngine
             .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
             .build();
 
-        Texture texture = Texture(device, "..\\Resources\\Textures\\qilin.jpg");
+        Texture texture = Texture(device, uploadManager, "..\\Resources\\Textures\\qilin.jpg");
 
         VkDescriptorImageInfo imageInfo{};
         imageInfo.sampler = texture.getSampler();
         imageInfo.imageView = texture.getImageView();
         imageInfo.imageLayout = texture.getImageLayout();
 
-        std::vector<VkDescriptorSet> globalDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        std::vector<VkDescriptorSet> globalDescriptorSets(renderer.getFramesInFlight());
         for (int i = 0; i < globalDescriptorSets.size(); i++)
         {
             auto bufferInfo = uniformBuffers[i]->descriptorInfo();
@@ -76,12 +107,40 @@ namespace VoxelEngine
                 .build(globalDescriptorSets[i]);
         }
 
-        SimpleRenderSystem simpleRenderSystem{device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
+        SimpleRenderSystem simpleRenderSystem{device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout(), jobSystem, transforms};
+
+        // Indirect terrain path, I toggles back to one draw per chunk to compare the CPU cost
+        std::unique_ptr<TerrainRenderSystem> terrainRenderSystem;
+        if (TerrainRenderSystem::isSupported(device))
+        {
+            terrainRenderSystem = std::make_unique<TerrainRenderSystem>(device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout());
+        }
+        bool useIndirectTerrain = terrainRenderSystem != nullptr;
+
+        const PipelineCacheStats pipelineStats = device.getPipelineCacheStats();
+        std::cout << "[pipelines] " << pipelineStats.pipelineCount << " created in "
+                  << pipelineStats.creationMicroseconds / 1000.0 << " ms, "
+                  << (pipelineStats.loadedFromDisk ? "warm cache (" + std::to_string(pipelineStats.loadedBytes) + " bytes)" : std::string{"cold cache"})
+                  << std::endl;
+        const ShaderManager::Stats shaderStats = device.shaderManager().getStats();
+        std::cout << "[shaders] compiled: " << shaderStats.compiled << " in " << shaderStats.compileMicroseconds / 1000.0
+                  << " ms, from disk cache: " << shaderStats.diskHits << std::endl;
+        bool toggleKeyWasPressed = false;
+        bool recordingKeyWasPressed = false;
+        size_t recordingMode = 0;
+        bool presentModeKeyWasPressed = false;
+        size_t presentModeIndex = 0;
+        bool imageCountKeyWasPressed = false;
+        size_t imageCountIndex = 0;
+        float statsTimer = 0.f;
+        uint32_t statsFrames = 0;
+
         Camera camera{};
         // camera.setViewDirection(glm::vec3{0.f}, glm::vec3{0.5f, 0.f, 1.f});
         camera.setViewTarget(glm::vec3{-1.0f, -2.0f, 2.0f}, glm::vec3{0.f, 0.f, 2.5f});
 
-        auto viewerObject = Object::createObject();
+        const Entity viewer = registry.create();
+        registry.emplace<TransformComponent>(viewer).translation.y = SPAWN_HEIGHT;
         KeyboardController cameraController{};
 
         auto currentTime = std::chrono::high_resolution_clock::now();
@@ -106,33 +165,62 @@ namespace VoxelEngine
                 -sin(lightAngle),
                 -1.f});
 
-            // Supongamos que quieres que rote a 30 grados por segundo
-            float rotationSpeedDegrees = 30.f;
-            float rotationSpeedRadians = glm::radians(rotationSpeedDegrees);
+            registry.each<TransformHandleComponent, SpinComponent>(
+                [&](Entity, TransformHandleComponent &transform, SpinComponent &spin)
+                {
+                    // Keep the angles in [0, 2pi]
+                    const glm::vec3 rotation = transforms.getRotation(transform.handle) + spin.angularVelocity * frameTime;
+                    transforms.setRotation(transform.handle, glm::mod(rotation, glm::two_pi<float>()));
+                });
 
-            // Asumiendo que el objeto que quieres girar es el primero (objeto 0)
-            if (!objects.empty())
+            const bool toggleKeyPressed = glfwGetKey(window.getGLFWWindow(), GLFW_KEY_I) == GLFW_PRESS;
+            if (toggleKeyPressed && !toggleKeyWasPressed && terrainRenderSystem)
             {
-                float newYRotation = objects[0].transform.rotation.y + rotationSpeedRadians * frameTime;
-            
-                // Mantener el ángulo en [0, 2pi]
-                if (newYRotation > glm::two_pi<float>()) {
-                    newYRotation -= glm::two_pi<float>();
-                }
-            
-                objects[0].transform.rotation.y = newYRotation;
+                useIndirectTerrain = !useIndirectTerrain;
             }
+            toggleKeyWasPressed = toggleKeyPressed;
 
-            cameraController.moveInPlaneXZ(window.getGLFWWindow(), frameTime, viewerObject);
-            camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+            const bool recordingKeyPressed = glfwGetKey(window.getGLFWWindow(), GLFW_KEY_T) == GLFW_PRESS;
+            if (recordingKeyPressed && !recordingKeyWasPressed)
+            {
+                recordingMode = (recordingMode + 1) % RECORDING_THREAD_COUNTS.size();
+            }
+            recordingKeyWasPressed = recordingKeyPressed;
+            const uint32_t recordingThreads = RECORDING_THREAD_COUNTS[recordingMode];
+
+            const bool presentModeKeyPressed = glfwGetKey(window.getGLFWWindow(), GLFW_KEY_P) == GLFW_PRESS;
+            if (presentModeKeyPressed && !presentModeKeyWasPressed)
+            {
+                presentModeIndex = (presentModeIndex + 1) % PRESENT_MODES.size();
+                renderer.setPresentMode(PRESENT_MODES[presentModeIndex]);
+                renderer.resetLatencyStats();
+            }
+            presentModeKeyWasPressed = presentModeKeyPressed;
+
+            const bool imageCountKeyPressed = glfwGetKey(window.getGLFWWindow(), GLFW_KEY_O) == GLFW_PRESS;
+            if (imageCountKeyPressed && !imageCountKeyWasPressed)
+            {
+                imageCountIndex = (imageCountIndex + 1) % SWAPCHAIN_IMAGE_COUNTS.size();
+                renderer.setImageCount(SWAPCHAIN_IMAGE_COUNTS[imageCountIndex]);
+                renderer.resetLatencyStats();
+            }
+            imageCountKeyWasPressed = imageCountKeyPressed;
+
+            TransformComponent &viewerTransform = registry.get<TransformComponent>(viewer);
+            cameraController.moveInPlaneXZ(window.getGLFWWindow(), frameTime, viewerTransform);
+            camera.setViewYXZ(viewerTransform.translation, viewerTransform.rotation);
+
+            uploadManager.poll();
+            chunkManager.update(viewerTransform.translation);
 
             float aspectRatio = renderer.getAspectRatio();
             // camera.setOrthographicProjection(-aspectRatio, aspectRatio, -1.f, 1.f, -1.f, 1.f);
-            camera.setPerspectiveProjection(glm::radians(50.f), aspectRatio, 0.1f, 100.f);
+            camera.setPerspectiveProjection(glm::radians(50.f), aspectRatio, 0.1f, 500.f);
 
             if (auto commandBuffer = renderer.beginFrame())
             {
                 int frameIndex = renderer.getFrameIndex();
+                simpleRenderSystem.reloadShaders(renderer.getSwapChainRenderPass());
                 FrameInfo frameInfo{frameIndex, frameTime, commandBuffer, camera, globalDescriptorSets[frameIndex]};
 
                 // Update global uniform buffer
@@ -143,11 +231,91 @@ namespace VoxelEngine
                 uniformBuffers[frameIndex]->writeToBuffer(&ubo);
                 uniformBuffers[frameIndex]->flush();
 
+                // Culling is a compute pass, it has to run outside the render pass
+                if (useIndirectTerrain)
+                {
+                    terrainRenderSystem->cull(frameInfo, chunkManager, renderer.getSwapChainExtent());
+                }
+
                 // Render
-                renderer.beginSwapChainRenderPass(commandBuffer);
-                simpleRenderSystem.renderGameObjects(frameInfo, objects);
+                renderer.beginSwapChainRenderPass(commandBuffer, recordingThreads > 0 ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+                simpleRenderSystem.renderGameObjects(frameInfo, registry, renderer, recordingThreads);
+                if (useIndirectTerrain)
+                {
+                    // A handful of commands, one secondary buffer when the pass can't take them inline
+                    if (recordingThreads > 0)
+                    {
+                        FrameInfo terrainFrameInfo = frameInfo;
+                        terrainFrameInfo.commandBuffer = renderer.beginSecondaryCommandBuffer(0);
+                        terrainRenderSystem->render(terrainFrameInfo, chunkManager);
+                        renderer.endSecondaryCommandBuffer(terrainFrameInfo.commandBuffer);
+                        vkCmdExecuteCommands(commandBuffer, 1, &terrainFrameInfo.commandBuffer);
+                    }
+                    else
+                    {
+                        terrainRenderSystem->render(frameInfo, chunkManager);
+                    }
+                }
+                else
+                {
+                    simpleRenderSystem.renderChunks(frameInfo, chunkManager, renderer, recordingThreads);
+                }
                 renderer.endSwapChainRenderPass(commandBuffer);
+                if (useIndirectTerrain)
+                {
+                    terrainRenderSystem->buildDepthPyramid(frameInfo, renderer.getCurrentDepthImage(), renderer.getCurrentDepthImageView(), renderer.getDepthFormat());
+                }
                 renderer.endFrame();
+
+                statsTimer += frameTime;
+                statsFrames++;
+                if (statsTimer >= 2.f)
+                {
+                    FrameTimeline &frameTimeline = renderer.getFrameTimeline();
+                    std::cout << "[frames] in flight: " << renderer.getFramesInFlight()
+                              << (frameTimeline.usesTimelineSemaphore() ? " (timeline semaphore)" : " (fences)")
+                              << ", cpu wait: " << frameTimeline.getWaitMicroseconds() / statsFrames << " us/frame"
+                              << ", frame: " << statsTimer * 1000000.f / statsFrames << " us" << std::endl;
+                    frameTimeline.resetWaitMicroseconds();
+
+                    const LatencyStats &latency = renderer.getLatencyStats();
+                    if (latency.frameCount > 0)
+                    {
+                        std::cout << "[present] mode: " << SwapChain::getPresentModeName(renderer.getPresentMode())
+                                  << ", images: " << renderer.getImageCount()
+                                  << ", start to submit: " << latency.startToSubmitMicroseconds / latency.frameCount << " us"
+                                  << ", submit to present: " << latency.submitToPresentMicroseconds / latency.frameCount << " us" << std::endl;
+                    }
+                    renderer.resetLatencyStats();
+                    statsFrames = 0;
+                    statsTimer = 0.f;
+                    const RenderStats &stats = useIndirectTerrain ? terrainRenderSystem->getLastStats() : simpleRenderSystem.getLastChunkStats();
+                    std::cout << (useIndirectTerrain ? "[indirect]" : "[direct]")
+                              << " chunks: " << stats.drawCount << "/" << stats.candidateCount
+                              << ", draw calls: " << stats.drawCalls
+                              << ", record: " << stats.recordMicroseconds << " us"
+                              << ", recording threads: " << (recordingThreads > 0 ? std::to_string(recordingThreads) : std::string{"inline"}) << std::endl;
+
+                    const RenderStats &objectStats = simpleRenderSystem.getLastObjectStats();
+                    std::cout << "[objects] visible: " << objectStats.drawCount << "/" << objectStats.candidateCount
+                              << ", draw calls: " << objectStats.drawCalls
+                              << ", cull: " << objectStats.cullMicroseconds << " us" << std::endl;
+
+                    const auto heapStats = device.allocator().getHeapStats();
+                    for (size_t heapIndex = 0; heapIndex < heapStats.size(); heapIndex++)
+                    {
+                        const MemoryAllocator::HeapStats &heap = heapStats[heapIndex];
+                        if (heap.blockCount == 0)
+                        {
+                            continue;
+                        }
+                        std::cout << "[memory] heap " << heapIndex
+                                  << " used: " << heap.usedBytes / (1024 * 1024) << "/" << heap.reservedBytes / (1024 * 1024) << " MiB"
+                                  << ", blocks: " << heap.blockCount
+                                  << ", allocations: " << heap.allocationCount
+                                  << ", fragmentation: " << heap.getFragmentation() * 100.f << "%" << std::endl;
+                    }
+                }
             }
         }
         vkDeviceWaitIdle(device.device());
@@ -155,24 +323,27 @@ namespace VoxelEngine
 
     void App::loadObjects()
     {
-        std::shared_ptr<Model> smoothVaseModel = Model::createModelFromFile(device, "..\\Resources\\Models\\qilin.obj");
-        std::shared_ptr<Model> flatVaseModel = Model::createModelFromFile(device, "..\\Resources\\Models\\flat_vase.obj");
-
-        auto obj1 = Object::createObject();
-        obj1.model = smoothVaseModel;
-        obj1.transform.translation = {-.5f, .5f, 2.5f};
-        float radianes = glm::radians(180.0f);
-        obj1.transform.rotation = {0.f, 0.f, 0.f};
-        // obj1.transform.scale = {3.f, 1.5f, 3.f};
-        obj1.transform.scale = {.001f, .001f, .001f};
-
-        objects.push_back(std::move(obj1));
-
-        // auto obj2 = Object::createObject();
-        // obj2.model = flatVaseModel;
-        // obj2.transform.translation = {.5f, .5f, 2.5f};
-        // obj2.transform.scale = {3.f, 1.5f, 3.f};
-        //
-        // objects.push_back(std::move(obj2));
+        models.push_back(Model::createModelFromFile(device, uploadManager, "..\\Resources\\Models\\qilin.obj"));
+        Model *smoothVaseModel = models.back().get();
+
+        const Entity obj1 = registry.create();
+        registry.emplace<ModelComponent>(obj1, smoothVaseModel);
+        TransformComponent transform1{};
+        transform1.translation = {-.5f, .5f + SPAWN_HEIGHT, 2.5f};
+        transform1.rotation = {0.f, 0.f, 0.f};
+        // transform1.scale = {3.f, 1.5f, 3.f};
+        transform1.scale = {.001f, .001f, .001f};
+        registry.emplace<TransformHandleComponent>(obj1, transforms.create(transform1));
+        // Spins 30 degrees per second around y
+        registry.emplace<SpinComponent>(obj1, glm::vec3{0.f, glm::radians(30.f), 0.f});
+
+        // models.push_back(Model::createModelFromFile(device, uploadManager, "..\\Resources\\Models\\flat_vase.obj"));
+        // Model *flatVaseModel = models.back().get();
+        // const Entity obj2 = registry.create();
+        // registry.emplace<ModelComponent>(obj2, flatVaseModel);
+        // TransformComponent transform2{};
+        // transform2.translation = {.5f, .5f, 2.5f};
+        // transform2.scale = {3.f, 1.5f, 3.f};
+        // registry.emplace<TransformHandleComponent>(obj2, transforms.create(transform2));
     }
 }
\ No newline at end of file
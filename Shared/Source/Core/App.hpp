@@ -4,7 +4,13 @@
 #include "Platform/Device.hpp"
 #include "Platform/Renderer.hpp"
 #include "Platform/Descriptors.hpp"
-#include "Object.hpp"
+#include "Platform/UploadManager.hpp"
+#include "Components.hpp"
+#include "Registry.hpp"
+#include "TransformPool.hpp"
+#include "JobSystem.hpp"
+#include "World/ChunkManager.hpp"
+#include "World/TerrainGenerator.hpp"
 
 #include <memory>
 #include <vector>
@@ -16,6 +22,8 @@ namespace VoxelEngine
     public:
         static constexpr int width = 800;
         static constexpr int height = 600;
+        // Overrides the renderer's frames in flight, 1 to SwapChain::MAX_FRAMES_IN_FLIGHT
+        static constexpr const char *FRAMES_IN_FLIGHT_VARIABLE = "VOXEL_ENGINE_FRAMES_IN_FLIGHT";
 
         App();
         ~App();
@@ -27,13 +35,24 @@ namespace VoxelEngine
 
     private:
         void loadObjects();
+        static uint32_t getConfiguredFramesInFlight();
 
         Window window{width, height, "Hello World!"};
         Device device{window};
-        Renderer renderer{window, device};
+        Renderer renderer{window, device, getConfiguredFramesInFlight()};
+        UploadManager uploadManager{device};
 
         // note: order of declarations matter
         std::unique_ptr<DescriptorPool> globalPool;
-        std::vector<Object> objects;
+        // Models before the registry, ModelComponent only points at them
+        std::vector<std::unique_ptr<Model>> models;
+        Registry registry{};
+        // Transforms of the drawn entities, see TransformHandleComponent
+        TransformPool transforms{};
+
+        // ChunkManager must go before the job system, it waits for its jobs on destruction
+        JobSystem jobSystem{};
+        TerrainGenerator terrainGenerator{};
+        ChunkManager chunkManager{device, uploadManager, jobSystem, terrainGenerator};
     };
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-#include "Object.hpp"
+#include "Components.hpp"
 
 namespace VoxelEngine
 {
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Platform/Model.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdint>
+
+namespace VoxelEngine
+{
+
+    // Plain transform for entities nothing draws, like the viewer
+    struct TransformComponent
+    {
+        glm::vec3 translation{};
+        glm::vec3 rotation{};
+        glm::vec3 scale{1.f, 1.f, 1.f};
+        // uniform scaling
+        // float scale = 1.f;
+
+        glm::mat4 mat4();
+        glm::mat3 normalMatrix();
+
+        bool operator==(const TransformComponent &) const = default;
+    };
+
+    // Drawn entities keep their transform in the App's TransformPool, written through its setters so
+    // only the entities that moved are refit. Whoever creates the handle destroys it
+    struct TransformHandleComponent
+    {
+        uint32_t handle = UINT32_MAX; // TransformPool::Handle
+    };
+
+    // Non-owning, models are owned by whoever loaded them and must outlive the entity
+    struct ModelComponent
+    {
+        Model *model = nullptr;
+    };
+
+    // Optional, entities without one draw untinted with material 0
+    struct MaterialComponent
+    {
+        glm::vec3 color{1.f, 1.f, 1.f};
+        uint32_t materialId = 0;
+    };
+
+    // Spins the entity's rotation every frame, in radians per second
+    struct SpinComponent
+    {
+        glm::vec3 angularVelocity{};
+    };
+}
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include "DepthPyramid.hpp"
+
+#include "Platform/SwapChain.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <stdexcept>
+
+namespace VoxelEngine
+{
+    constexpr uint32_t GROUP_SIZE = 8;
+
+    static bool hasStencilComponent(VkFormat format)
+    {
+        return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+    }
+
+    DepthPyramid::DepthPyramid(Device &device) : device{device}
+    {
+        createSampler();
+        createDescriptorSetLayout();
+        createPipeline();
+    }
+
+    DepthPyramid::~DepthPyramid()
+    {
+        retireResources();
+        vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+        vkDestroySampler(device.device(), sampler, nullptr);
+    }
+
+    void DepthPyramid::createSampler()
+    {
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.anisotropyEnable = VK_FALSE;
+        samplerInfo.maxAnisotropy = 1.0f;
+        samplerInfo.compareEnable = VK_FALSE;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+        samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+        if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid sampler!");
+        }
+    }
+
+    void DepthPyramid::createDescriptorSetLayout()
+    {
+        setLayout = DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build();
+    }
+
+    void DepthPyramid::createPipeline()
+    {
+        VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+        if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+        }
+
+        pipeline = std::make_unique<ComputePipeline>(device, "../Resources/Shaders/DepthPyramid.comp", pipelineLayout);
+    }
+
+    bool DepthPyramid::resize(VkCommandBuffer commandBuffer, VkExtent2D depthExtent)
+    {
+        const VkExtent2D newExtent{std::max(depthExtent.width / 2, 1u), std::max(depthExtent.height / 2, 1u)};
+        if (resources && newExtent.width == resources->extent.width && newExtent.height == resources->extent.height)
+        {
+            return false;
+        }
+
+        retireResources();
+        resources = createResources(depthExtent);
+
+        // Stays in GENERAL for its whole life, it is written as storage and sampled in turn
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = resources->image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, resources->levelCount, 0, 1};
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+        return true;
+    }
+
+    std::unique_ptr<DepthPyramid::Resources> DepthPyramid::createResources(VkExtent2D depthExtent)
+    {
+        auto created = std::make_unique<Resources>();
+        Resources &r = *created;
+        r.extent = {std::max(depthExtent.width / 2, 1u), std::max(depthExtent.height / 2, 1u)};
+        r.levelCount = std::min(static_cast<uint32_t>(std::bit_width(std::max(r.extent.width, r.extent.height))), MAX_LEVELS);
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = r.extent.width;
+        imageInfo.extent.height = r.extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = r.levelCount;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.flags = 0;
+
+        device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, r.image, r.imageMemory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = r.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = r.levelCount;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device.device(), &viewInfo, nullptr, &r.fullView) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid image view!");
+        }
+
+        r.levelViews.resize(r.levelCount);
+        for (uint32_t level = 0; level < r.levelCount; level++)
+        {
+            viewInfo.subresourceRange.baseMipLevel = level;
+            viewInfo.subresourceRange.levelCount = 1;
+            if (vkCreateImageView(device.device(), &viewInfo, nullptr, &r.levelViews[level]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create depth pyramid image view!");
+            }
+        }
+
+        // A pool of its own, the old one still backs the sets of frames in flight
+        const uint32_t maxSets = MAX_LEVELS + SwapChain::MAX_FRAMES_IN_FLIGHT;
+        r.descriptorPool = DescriptorPool::Builder(device)
+            .setMaxSets(maxSets)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxSets)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, maxSets)
+            .build();
+
+        r.depthDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &set : r.depthDescriptorSets)
+        {
+            if (!r.descriptorPool->allocateDescriptor(setLayout->getDescriptorSetLayout(), set))
+            {
+                throw std::runtime_error("failed to allocate depth pyramid descriptor set!");
+            }
+        }
+
+        r.levelDescriptorSets.resize(r.levelCount - 1);
+        for (uint32_t level = 0; level + 1 < r.levelCount; level++)
+        {
+            VkDescriptorImageInfo sourceInfo{sampler, r.levelViews[level], VK_IMAGE_LAYOUT_GENERAL};
+            VkDescriptorImageInfo targetInfo{VK_NULL_HANDLE, r.levelViews[level + 1], VK_IMAGE_LAYOUT_GENERAL};
+            DescriptorWriter(*setLayout, *r.descriptorPool)
+                .writeImage(0, &sourceInfo)
+                .writeImage(1, &targetInfo)
+                .build(r.levelDescriptorSets[level]);
+        }
+        return created;
+    }
+
+    void DepthPyramid::retireResources()
+    {
+        if (!resources)
+        {
+            return;
+        }
+
+        // Frames still in flight may read the image or use the sets
+        device.deletionQueue().push([&device = device, retired = std::shared_ptr<Resources>(std::move(resources))]() mutable
+                                    {
+                                        for (VkImageView view : retired->levelViews)
+                                        {
+                                            vkDestroyImageView(device.device(), view, nullptr);
+                                        }
+                                        vkDestroyImageView(device.device(), retired->fullView, nullptr);
+                                        vkDestroyImage(device.device(), retired->image, nullptr);
+                                        device.freeMemory(retired->imageMemory);
+                                        retired.reset();
+                                    });
+    }
+
+    void DepthPyramid::build(VkCommandBuffer commandBuffer, int frameIndex, VkImage depthImage, VkImageView depthImageView, VkFormat depthFormat)
+    {
+        assert(resources && "Cannot build depth pyramid before resize");
+        Resources &r = *resources;
+
+        VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (hasStencilComponent(depthFormat))
+        {
+            depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+
+        VkDescriptorImageInfo depthInfo{sampler, depthImageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+        VkDescriptorImageInfo targetInfo{VK_NULL_HANDLE, r.levelViews[0], VK_IMAGE_LAYOUT_GENERAL};
+        DescriptorWriter(*setLayout, *r.descriptorPool)
+            .writeImage(0, &depthInfo)
+            .writeImage(1, &targetInfo)
+            .overwrite(r.depthDescriptorSets[frameIndex]);
+
+        // Depth writes of the render pass before the first reduction, and the culling pass of this
+        // frame done reading the pyramid before it is overwritten
+        std::array<VkImageMemoryBarrier, 2> barriers{};
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].image = depthImage;
+        barriers[0].subresourceRange = {depthAspect, 0, 1, 0, 1};
+
+        barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].image = r.image;
+        barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, r.levelCount, 0, 1};
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr,
+            static_cast<uint32_t>(barriers.size()), barriers.data());
+
+        pipeline->bind(commandBuffer);
+
+        for (uint32_t level = 0; level < r.levelCount; level++)
+        {
+            VkDescriptorSet set = level == 0 ? r.depthDescriptorSets[frameIndex] : r.levelDescriptorSets[level - 1];
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+
+            const uint32_t levelWidth = std::max(r.extent.width >> level, 1u);
+            const uint32_t levelHeight = std::max(r.extent.height >> level, 1u);
+            vkCmdDispatch(commandBuffer, (levelWidth + GROUP_SIZE - 1) / GROUP_SIZE, (levelHeight + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+            // The next level reads this one
+            VkImageMemoryBarrier levelBarrier{};
+            levelBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            levelBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            levelBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            levelBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            levelBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            levelBarrier.image = r.image;
+            levelBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0, 0, nullptr, 0, nullptr, 1, &levelBarrier);
+        }
+
+        // Hand the depth attachment back before the next render pass clears it
+        VkImageMemoryBarrier depthBarrier = barriers[0];
+        depthBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &depthBarrier);
+    }
+
+    VkDescriptorImageInfo DepthPyramid::descriptorInfo() const
+    {
+        return VkDescriptorImageInfo{sampler, resources->fullView, VK_IMAGE_LAYOUT_GENERAL};
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Platform/Device.hpp"
+#include "Platform/ComputePipeline.hpp"
+#include "Platform/Descriptors.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Hierarchical depth buffer for occlusion culling.
+    //
+    // Level 0 is half the size of the depth attachment and every texel of every level holds the
+    // farthest depth of the texels below it, so one sample proves that everything behind it
+    // is hidden. The image stays in VK_IMAGE_LAYOUT_GENERAL and is rebuilt after the render pass
+    // every frame; the culling pass of the next frame reads it together with that frame's matrix.
+    class DepthPyramid
+    {
+    public:
+        static constexpr uint32_t MAX_LEVELS = 16;
+
+        DepthPyramid(Device &device);
+        ~DepthPyramid();
+
+        DepthPyramid(const DepthPyramid &) = delete;
+        DepthPyramid &operator=(const DepthPyramid &) = delete;
+
+        // Recreates the pyramid for a new depth extent, returns true if it did. The layout transition
+        // is recorded into commandBuffer, call it before anything is recorded that uses the pyramid.
+        // Frames still in flight keep the old image until the deletion queue retires it
+        bool resize(VkCommandBuffer commandBuffer, VkExtent2D depthExtent);
+
+        // Depth must be in DEPTH_STENCIL_ATTACHMENT_OPTIMAL and is returned to it afterwards
+        void build(VkCommandBuffer commandBuffer, int frameIndex, VkImage depthImage, VkImageView depthImageView, VkFormat depthFormat);
+
+        // Nearest sampler over every level
+        VkDescriptorImageInfo descriptorInfo() const;
+        VkImage getImage() const { return resources->image; }
+        VkExtent2D getExtent() const { return resources->extent; }
+        uint32_t getLevelCount() const { return resources->levelCount; }
+
+    private:
+        // Everything that depends on the extent, replaced as a whole on resize
+        struct Resources
+        {
+            VkExtent2D extent{0, 0};
+            uint32_t levelCount = 0;
+            VkImage image = VK_NULL_HANDLE;
+            MemoryAllocation imageMemory{};
+            VkImageView fullView = VK_NULL_HANDLE;
+            std::vector<VkImageView> levelViews;
+
+            std::unique_ptr<DescriptorPool> descriptorPool;
+            // Level 0 reads the depth attachment of the current swap chain image, so it is rewritten
+            // each frame; one set per frame in flight keeps it away from sets the GPU is still using
+            std::vector<VkDescriptorSet> depthDescriptorSets;
+            // [i] reduces level i into level i + 1
+            std::vector<VkDescriptorSet> levelDescriptorSets;
+        };
+
+        void createSampler();
+        void createDescriptorSetLayout();
+        void createPipeline();
+        std::unique_ptr<Resources> createResources(VkExtent2D depthExtent);
+        void retireResources();
+
+        Device &device;
+
+        std::unique_ptr<Resources> resources;
+        VkSampler sampler;
+        std::unique_ptr<DescriptorSetLayout> setLayout;
+
+        VkPipelineLayout pipelineLayout;
+        std::unique_ptr<ComputePipeline> pipeline;
+    };
+}
@@ -7,6 +7,16 @@
 namespace VoxelEngine
 {
 
+    // CPU-side cost of recording one render system's draws
+    struct RenderStats
+    {
+        uint32_t candidateCount = 0; // meshes submitted before culling
+        uint32_t drawCount = 0;      // meshes drawn
+        uint32_t drawCalls = 0;      // vkCmdDraw* calls recorded
+        double cullMicroseconds = 0.0; // CPU culling, part of recordMicroseconds
+        double recordMicroseconds = 0.0;
+    };
+
     struct FrameInfo
     {
         int frameIndex;
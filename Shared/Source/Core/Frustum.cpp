@@ -0,0 +1,99 @@
+#include "Frustum.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VOXEL_ENGINE_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace VoxelEngine
+{
+    // from: https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+    void Frustum::extractPlanes(const glm::mat4 &projectionView, glm::vec4 planes[6])
+    {
+        const glm::vec4 row0{projectionView[0][0], projectionView[1][0], projectionView[2][0], projectionView[3][0]};
+        const glm::vec4 row1{projectionView[0][1], projectionView[1][1], projectionView[2][1], projectionView[3][1]};
+        const glm::vec4 row2{projectionView[0][2], projectionView[1][2], projectionView[2][2], projectionView[3][2]};
+        const glm::vec4 row3{projectionView[0][3], projectionView[1][3], projectionView[2][3], projectionView[3][3]};
+
+        planes[0] = row3 + row0; // left
+        planes[1] = row3 - row0; // right
+        planes[2] = row3 + row1; // top
+        planes[3] = row3 - row1; // bottom
+        planes[4] = row2;        // near
+        planes[5] = row3 - row2; // far
+
+        for (int i = 0; i < 6; i++)
+        {
+            planes[i] /= glm::length(glm::vec3{planes[i]});
+        }
+    }
+
+    Frustum::Frustum(const glm::mat4 &projectionView)
+    {
+        glm::vec4 planes[6];
+        extractPlanes(projectionView, planes);
+        for (int i = 0; i < 6; i++)
+        {
+            planeX[i] = planes[i].x;
+            planeY[i] = planes[i].y;
+            planeZ[i] = planes[i].z;
+            planeW[i] = planes[i].w;
+        }
+    }
+
+    // A box is outside if it lies behind any plane and inside if it lies in front of all of them.
+    // Per plane, distance is the signed distance of the center and radius the box's projection
+    // onto the normal.
+    Frustum::Intersection Frustum::classify(const BoundingBox &box) const
+    {
+        const glm::vec3 center = box.getCenter();
+        const glm::vec3 extent = box.getExtent();
+
+#ifdef VOXEL_ENGINE_FRUSTUM_SSE
+        const __m128 centerX = _mm_set1_ps(center.x);
+        const __m128 centerY = _mm_set1_ps(center.y);
+        const __m128 centerZ = _mm_set1_ps(center.z);
+        const __m128 extentX = _mm_set1_ps(extent.x);
+        const __m128 extentY = _mm_set1_ps(extent.y);
+        const __m128 extentZ = _mm_set1_ps(extent.z);
+        const __m128 signMask = _mm_set1_ps(-0.f);
+        const __m128 zero = _mm_setzero_ps();
+
+        int outside = 0;
+        int intersecting = 0;
+        for (int i = 0; i < PADDED_PLANE_COUNT; i += 4)
+        {
+            const __m128 normalX = _mm_load_ps(planeX + i);
+            const __m128 normalY = _mm_load_ps(planeY + i);
+            const __m128 normalZ = _mm_load_ps(planeZ + i);
+
+            __m128 distance = _mm_add_ps(_mm_mul_ps(normalX, centerX), _mm_load_ps(planeW + i));
+            distance = _mm_add_ps(distance, _mm_mul_ps(normalY, centerY));
+            distance = _mm_add_ps(distance, _mm_mul_ps(normalZ, centerZ));
+
+            __m128 radius = _mm_mul_ps(_mm_andnot_ps(signMask, normalX), extentX);
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, normalY), extentY));
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, normalZ), extentZ));
+
+            outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+            intersecting |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), zero));
+        }
+#else
+        bool outside = false;
+        bool intersecting = false;
+        for (int i = 0; i < PADDED_PLANE_COUNT; i++)
+        {
+            const float distance = planeX[i] * center.x + planeY[i] * center.y + planeZ[i] * center.z + planeW[i];
+            const float radius = glm::abs(planeX[i]) * extent.x + glm::abs(planeY[i]) * extent.y + glm::abs(planeZ[i]) * extent.z;
+            outside |= distance + radius < 0.f;
+            intersecting |= distance - radius < 0.f;
+        }
+#endif
+
+        if (outside)
+        {
+            return Intersection::Outside;
+        }
+        return intersecting ? Intersection::Intersecting : Intersection::Inside;
+    }
+}
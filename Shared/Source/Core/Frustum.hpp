@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Utils/BoundingBox.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+namespace VoxelEngine
+{
+    // The six planes of a camera frustum, tested four at a time with SSE where available.
+    //
+    // Planes are kept as structure of arrays and padded to eight with planes that accept
+    // everything, so a box test is two rounds of four planes with no scalar tail.
+    class Frustum
+    {
+    public:
+        enum class Intersection
+        {
+            Outside,
+            Intersecting,
+            Inside
+        };
+
+        Frustum() = default;
+        explicit Frustum(const glm::mat4 &projectionView);
+
+        // Inward facing, normalized planes of a [0, 1] depth range projection-view matrix:
+        // left, right, top, bottom, near, far
+        static void extractPlanes(const glm::mat4 &projectionView, glm::vec4 planes[6]);
+
+        Intersection classify(const BoundingBox &box) const;
+        bool intersects(const BoundingBox &box) const { return classify(box) != Intersection::Outside; }
+
+    private:
+        static constexpr int PADDED_PLANE_COUNT = 8;
+
+        alignas(16) float planeX[PADDED_PLANE_COUNT]{};
+        alignas(16) float planeY[PADDED_PLANE_COUNT]{};
+        alignas(16) float planeZ[PADDED_PLANE_COUNT]{};
+        alignas(16) float planeW[PADDED_PLANE_COUNT]{1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f};
+    };
+}
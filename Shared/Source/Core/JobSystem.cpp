@@ -0,0 +1,96 @@
+#include "JobSystem.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace VoxelEngine
+{
+
+    JobSystem::JobSystem(uint32_t workerCount)
+    {
+        for (auto &queue : queues)
+        {
+            queue = std::make_unique<MPMCQueue<Job>>(QUEUE_CAPACITY);
+        }
+
+        if (workerCount == 0)
+        {
+            const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = std::max(hardwareThreads, 2u) - 1;
+        }
+
+        workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back(&JobSystem::workerLoop, this);
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        running.store(false, std::memory_order_release);
+        pendingJobs.release(static_cast<std::ptrdiff_t>(workers.size()));
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        // Jobs still queued are destroyed with the queues without running
+    }
+
+    bool JobSystem::submit(Job job, uint32_t priority)
+    {
+        assert(priority < PRIORITY_LEVELS && "Job priority out of range");
+
+        if (!queues[priority]->tryPush(std::move(job)))
+        {
+            return false;
+        }
+        pendingJobs.release();
+        return true;
+    }
+
+    size_t JobSystem::getPendingJobCount() const
+    {
+        size_t count = 0;
+        for (const auto &queue : queues)
+        {
+            count += queue->getSizeApprox();
+        }
+        return count;
+    }
+
+    bool JobSystem::tryPopJob(Job &job)
+    {
+        for (auto &queue : queues)
+        {
+            if (queue->tryPop(job))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void JobSystem::workerLoop()
+    {
+        Job job;
+        for (;;)
+        {
+            pendingJobs.acquire();
+            if (!running.load(std::memory_order_acquire))
+            {
+                return;
+            }
+
+            // Every release matches one pushed job, but another worker may have taken the one
+            // this wake-up was for, in which case one of the other levels holds ours
+            while (!tryPopJob(job))
+            {
+                std::this_thread::yield();
+            }
+            job();
+            job = nullptr;
+        }
+    }
+}
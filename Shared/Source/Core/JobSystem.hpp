@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Utils/MPMCQueue.hpp"
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Fixed pool of worker threads fed by lock-free queues, one per priority level.
+    //
+    // Workers always drain the most urgent non-empty level first. Jobs must not block on other
+    // jobs, and anything they hand back to the main thread goes through its own queue.
+    class JobSystem
+    {
+    public:
+        using Job = std::function<void()>;
+
+        static constexpr uint32_t PRIORITY_LEVELS = 4;
+        static constexpr uint32_t HIGHEST_PRIORITY = 0;
+        static constexpr uint32_t LOWEST_PRIORITY = PRIORITY_LEVELS - 1;
+        static constexpr size_t QUEUE_CAPACITY = 4096;
+
+        // workerCount 0 uses every hardware thread but one, which is left to the render thread
+        explicit JobSystem(uint32_t workerCount = 0);
+        ~JobSystem();
+
+        JobSystem(const JobSystem &) = delete;
+        JobSystem &operator=(const JobSystem &) = delete;
+
+        // Returns false without taking the job when its priority level is full
+        bool submit(Job job, uint32_t priority = LOWEST_PRIORITY);
+
+        uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+        size_t getPendingJobCount() const;
+
+    private:
+        void workerLoop();
+        bool tryPopJob(Job &job);
+
+        std::array<std::unique_ptr<MPMCQueue<Job>>, PRIORITY_LEVELS> queues;
+        // Counts queued jobs so idle workers sleep instead of spinning
+        std::counting_semaphore<> pendingJobs{0};
+        std::atomic<bool> running{true};
+        std::vector<std::thread> workers;
+    };
+}
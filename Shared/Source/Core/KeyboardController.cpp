@@ -3,7 +3,7 @@
 namespace VoxelEngine
 {
 
-    void KeyboardController::moveInPlaneXZ(GLFWwindow* window, float dt, Object& object)
+    void KeyboardController::moveInPlaneXZ(GLFWwindow* window, float dt, TransformComponent& transform)
     {
         glm::vec3 rotate{0};
 
@@ -14,14 +14,14 @@ namespace VoxelEngine
 
         if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon())
         {
-            object.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
+            transform.rotation += lookSpeed * dt * glm::normalize(rotate);
         }
 
         // Limit pitch values about +/- 85 degrees
-        object.transform.rotation.x = glm::clamp(object.transform.rotation.x, -1.5f, 1.5f);
-        object.transform.rotation.y = glm::mod(object.transform.rotation.y, glm::two_pi<float>());
+        transform.rotation.x = glm::clamp(transform.rotation.x, -1.5f, 1.5f);
+        transform.rotation.y = glm::mod(transform.rotation.y, glm::two_pi<float>());
 
-        float yaw = object.transform.rotation.y;
+        float yaw = transform.rotation.y;
         const glm::vec3 forwardDir{glm::sin(yaw), 0.f, glm::cos(yaw)};
         const glm::vec3 rightDir{forwardDir.z, 0.f, -forwardDir.x};
         const glm::vec3 upDir{0.f, -1.f, 0.f};
@@ -36,7 +36,7 @@ namespace VoxelEngine
 
         if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon())
         {
-            object.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+            transform.translation += moveSpeed * dt * glm::normalize(moveDir);
         }
     }
 }
\ No newline at end of file
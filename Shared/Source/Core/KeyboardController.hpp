@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Object.hpp"
+#include "Components.hpp"
 #include "Platform/Window.hpp"
 
 namespace VoxelEngine
@@ -23,7 +23,7 @@ namespace VoxelEngine
             int lookDown = GLFW_KEY_DOWN;
         };
 
-        void moveInPlaneXZ(GLFWwindow* window, float dt, Object& object);
+        void moveInPlaneXZ(GLFWwindow* window, float dt, TransformComponent& transform);
 
         KeyMappings keys{};
         float moveSpeed{3.5f};
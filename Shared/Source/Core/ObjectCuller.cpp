@@ -0,0 +1,116 @@
+#include "ObjectCuller.hpp"
+
+#include <algorithm>
+
+namespace VoxelEngine
+{
+    BoundingBox ObjectCuller::computeWorldBounds(const Entry &entry) const
+    {
+        const glm::mat4 &worldMatrix = transforms.getWorldMatrix(entry.transform);
+        const BoundingBox &localBounds = entry.model->getBoundingBox();
+        if (localBounds.isEmpty())
+        {
+            const glm::vec3 translation{worldMatrix[3]};
+            return BoundingBox{translation, translation};
+        }
+        return localBounds.transformed(worldMatrix);
+    }
+
+    void ObjectCuller::removeEntry(Entry &entry)
+    {
+        if (entry.proxy != DynamicBvh::NULL_NODE)
+        {
+            bvh.destroyProxy(entry.proxy);
+        }
+        entry = Entry{};
+    }
+
+    void ObjectCuller::update(Registry &registry)
+    {
+        updateCount++;
+        changed.clear();
+
+        registry.each<TransformHandleComponent, ModelComponent>(
+            [&](Entity entity, TransformHandleComponent &transform, ModelComponent &model)
+            {
+                if (!model.model || transform.handle == TransformPool::INVALID_HANDLE)
+                {
+                    return;
+                }
+                if (entity.index >= entries.size())
+                {
+                    entries.resize(entity.index + 1);
+                }
+
+                // A different generation means the slot was reused since the last update
+                Entry &entry = entries[entity.index];
+                if (entry.transform != TransformPool::INVALID_HANDLE && entry.generation != entity.generation)
+                {
+                    removeEntry(entry);
+                }
+
+                if (entry.transform == TransformPool::INVALID_HANDLE)
+                {
+                    entry.generation = entity.generation;
+                    entry.model = model.model;
+                    entry.transform = transform.handle;
+                    changed.push_back(entity.index);
+                }
+                else if (entry.model != model.model || entry.transform != transform.handle || transforms.isDirty(transform.handle))
+                {
+                    entry.model = model.model;
+                    entry.transform = transform.handle;
+                    changed.push_back(entity.index);
+                }
+                entry.lastSeen = updateCount;
+            });
+
+        // Only entries written since the last update are dirty, the rest keep last frame's matrices
+        transforms.updateMatrices();
+
+        for (uint32_t index : changed)
+        {
+            Entry &entry = entries[index];
+            if (entry.proxy == DynamicBvh::NULL_NODE)
+            {
+                entry.proxy = bvh.createProxy(computeWorldBounds(entry), index);
+            }
+            else
+            {
+                bvh.moveProxy(entry.proxy, computeWorldBounds(entry));
+            }
+        }
+
+        for (Entry &entry : entries)
+        {
+            if (entry.transform != TransformPool::INVALID_HANDLE && entry.lastSeen != updateCount)
+            {
+                removeEntry(entry);
+            }
+        }
+    }
+
+    void ObjectCuller::cull(const Frustum &frustum, std::vector<Entity> &visibleEntities) const
+    {
+        visibleEntities.clear();
+        bvh.query(
+            [&](const BoundingBox &box)
+            {
+                switch (frustum.classify(box))
+                {
+                case Frustum::Intersection::Outside:
+                    return DynamicBvh::Visit::Skip;
+                case Frustum::Intersection::Inside:
+                    return DynamicBvh::Visit::TakeAll;
+                default:
+                    return DynamicBvh::Visit::Descend;
+                }
+            },
+            [&](uint32_t index)
+            { visibleEntities.push_back(Entity{index, entries[index].generation}); });
+
+        // Entity order keeps draws stable from frame to frame
+        std::sort(visibleEntities.begin(), visibleEntities.end(), [](Entity a, Entity b)
+                  { return a.index < b.index; });
+    }
+}
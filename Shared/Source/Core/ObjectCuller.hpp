@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Components.hpp"
+#include "Frustum.hpp"
+#include "Registry.hpp"
+#include "TransformPool.hpp"
+#include "Utils/DynamicBvh.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Keeps a DynamicBvh of entity world bounds and answers which entities the camera can see.
+    //
+    // Tracks every entity with a TransformHandleComponent and a ModelComponent. update() inserts new
+    // ones, drops the ones that are gone and refits the ones whose transform is dirty in the
+    // TransformPool, so static entities cost a bit test per frame and no matrix. The pool's cached
+    // matrices are handed out for drawing too.
+    class ObjectCuller
+    {
+    public:
+        ObjectCuller(TransformPool &transforms) : transforms{transforms} {}
+
+        ObjectCuller(const ObjectCuller &) = delete;
+        ObjectCuller &operator=(const ObjectCuller &) = delete;
+
+        void update(Registry &registry);
+        // Entities in ascending index order
+        void cull(const Frustum &frustum, std::vector<Entity> &visibleEntities) const;
+
+        uint32_t getObjectCount() const { return bvh.getProxyCount(); }
+        // Cached matrices of an entity tracked by the last update
+        const glm::mat4 &getWorldMatrix(Entity entity) const { return transforms.getWorldMatrix(entries[entity.index].transform); }
+        const glm::mat4 &getNormalMatrix(Entity entity) const { return transforms.getNormalMatrix(entries[entity.index].transform); }
+
+    private:
+        struct Entry
+        {
+            uint32_t proxy = DynamicBvh::NULL_NODE;
+            uint32_t generation = 0;
+            uint64_t lastSeen = 0;
+            const Model *model = nullptr;
+            TransformPool::Handle transform = TransformPool::INVALID_HANDLE;
+        };
+
+        BoundingBox computeWorldBounds(const Entry &entry) const;
+        void removeEntry(Entry &entry);
+
+        TransformPool &transforms;
+        DynamicBvh bvh{};
+        // Indexed by entity index, the slot is unused while transform is INVALID_HANDLE
+        std::vector<Entry> entries;
+        uint64_t updateCount = 0;
+        // Entries whose bounds need to be (re)inserted once the matrices are current
+        std::vector<uint32_t> changed;
+    };
+}
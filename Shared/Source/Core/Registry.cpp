@@ -0,0 +1,51 @@
+#include "Registry.hpp"
+
+#include <atomic>
+
+namespace VoxelEngine
+{
+    uint32_t Registry::nextTypeId()
+    {
+        static std::atomic<uint32_t> next{0};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Entity Registry::create()
+    {
+        Entity entity{};
+        if (!freeIndices.empty())
+        {
+            entity.index = freeIndices.back();
+            freeIndices.pop_back();
+        }
+        else
+        {
+            entity.index = static_cast<uint32_t>(generations.size());
+            generations.push_back(0);
+        }
+
+        entity.generation = generations[entity.index];
+        entityCount++;
+        return entity;
+    }
+
+    void Registry::destroy(Entity entity)
+    {
+        if (!isAlive(entity))
+        {
+            return;
+        }
+
+        for (auto &pool : pools)
+        {
+            if (pool)
+            {
+                pool->remove(entity.index);
+            }
+        }
+
+        generations[entity.index]++;
+        freeIndices.push_back(entity.index);
+        entityCount--;
+    }
+}
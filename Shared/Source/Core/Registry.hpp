@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Stable handle to an entity. The generation changes every time the index is reused, so a
+    // handle to a destroyed entity never aliases the entity that took its slot.
+    struct Entity
+    {
+        static constexpr uint32_t NULL_INDEX = UINT32_MAX;
+
+        uint32_t index = NULL_INDEX;
+        uint32_t generation = 0;
+
+        bool isNull() const { return index == NULL_INDEX; }
+        bool operator==(const Entity &) const = default;
+    };
+
+    // Entity component storage built on sparse sets.
+    //
+    // Every component type has its own pool: a dense array of components, a parallel dense array
+    // of the entities owning them, and a sparse array from entity index to dense index. Systems
+    // iterate the dense arrays directly, and each() walks the smallest pool of the requested types
+    // so iteration cost follows the rarest component.
+    //
+    // Adding or removing components may move others of the same type, so references returned by
+    // get() and the ones passed to each() only stay valid until the next structural change. Do
+    // not create, destroy, emplace or remove inside each(); collect the entities and do it after.
+    class Registry
+    {
+    public:
+        Registry() = default;
+
+        Registry(const Registry &) = delete;
+        Registry &operator=(const Registry &) = delete;
+
+        Entity create();
+        // Removes every component of the entity, does nothing for stale handles
+        void destroy(Entity entity);
+        bool isAlive(Entity entity) const
+        {
+            return entity.index < generations.size() && generations[entity.index] == entity.generation;
+        }
+        uint32_t getEntityCount() const { return entityCount; }
+
+        template <typename T, typename... Args>
+        T &emplace(Entity entity, Args &&...args)
+        {
+            assert(isAlive(entity) && "Adding a component to a dead entity");
+            return getPool<T>().emplace(entity, std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        void remove(Entity entity)
+        {
+            if (isAlive(entity))
+            {
+                getPool<T>().remove(entity.index);
+            }
+        }
+
+        template <typename T>
+        bool has(Entity entity) const
+        {
+            const Pool<T> *pool = findPool<T>();
+            return isAlive(entity) && pool && pool->contains(entity.index);
+        }
+
+        template <typename T>
+        T &get(Entity entity)
+        {
+            assert(has<T>(entity) && "Entity does not have the component");
+            return getPool<T>().get(entity.index);
+        }
+
+        // nullptr when the entity is dead or lacks the component
+        template <typename T>
+        T *tryGet(Entity entity)
+        {
+            Pool<T> *pool = findPool<T>();
+            return isAlive(entity) && pool && pool->contains(entity.index) ? &pool->get(entity.index) : nullptr;
+        }
+
+        template <typename T>
+        size_t count() const
+        {
+            const Pool<T> *pool = findPool<T>();
+            return pool ? pool->entities.size() : 0;
+        }
+
+        // Calls function(Entity, First &, Rest &...) for every entity that has all the components
+        template <typename First, typename... Rest, typename Function>
+        void each(Function &&function)
+        {
+            std::tuple<Pool<First> *, Pool<Rest> *...> pools{findPool<First>(), findPool<Rest>()...};
+            if (!std::apply([](auto *...pool) { return (pool && ...); }, pools))
+            {
+                return;
+            }
+
+            const std::vector<Entity> *smallest = &std::get<0>(pools)->entities;
+            std::apply([&](auto *...pool)
+                       { ((smallest = pool->entities.size() < smallest->size() ? &pool->entities : smallest), ...); },
+                       pools);
+
+            for (size_t i = 0; i < smallest->size(); i++)
+            {
+                const Entity entity = (*smallest)[i];
+                if (std::apply([&](auto *...pool) { return (pool->contains(entity.index) && ...); }, pools))
+                {
+                    std::apply([&](auto *...pool) { function(entity, pool->get(entity.index)...); }, pools);
+                }
+            }
+        }
+
+    private:
+        struct PoolBase
+        {
+            static constexpr uint32_t NULL_SLOT = UINT32_MAX;
+
+            virtual ~PoolBase() = default;
+            virtual void remove(uint32_t index) = 0;
+
+            bool contains(uint32_t index) const { return index < sparse.size() && sparse[index] != NULL_SLOT; }
+
+            // Entity index to dense slot
+            std::vector<uint32_t> sparse;
+            std::vector<Entity> entities;
+        };
+
+        template <typename T>
+        struct Pool : PoolBase
+        {
+            template <typename... Args>
+            T &emplace(Entity entity, Args &&...args)
+            {
+                if (entity.index >= sparse.size())
+                {
+                    sparse.resize(std::max<size_t>(entity.index + 1, sparse.size() * 2), NULL_SLOT);
+                }
+                if (sparse[entity.index] != NULL_SLOT)
+                {
+                    T &component = components[sparse[entity.index]];
+                    component = T{std::forward<Args>(args)...};
+                    return component;
+                }
+
+                sparse[entity.index] = static_cast<uint32_t>(entities.size());
+                entities.push_back(entity);
+                return components.emplace_back(T{std::forward<Args>(args)...});
+            }
+
+            void remove(uint32_t index) override
+            {
+                if (!contains(index))
+                {
+                    return;
+                }
+
+                // Swap the last component into the hole so the arrays stay dense
+                const uint32_t slot = sparse[index];
+                const uint32_t last = static_cast<uint32_t>(entities.size()) - 1;
+                if (slot != last)
+                {
+                    entities[slot] = entities[last];
+                    components[slot] = std::move(components[last]);
+                    sparse[entities[slot].index] = slot;
+                }
+                entities.pop_back();
+                components.pop_back();
+                sparse[index] = NULL_SLOT;
+            }
+
+            T &get(uint32_t index) { return components[sparse[index]]; }
+
+            std::vector<T> components;
+        };
+
+        static uint32_t nextTypeId();
+        template <typename T>
+        static uint32_t typeId()
+        {
+            static const uint32_t id = nextTypeId();
+            return id;
+        }
+
+        template <typename T>
+        Pool<T> *findPool() const
+        {
+            const uint32_t id = typeId<T>();
+            return id < pools.size() ? static_cast<Pool<T> *>(pools[id].get()) : nullptr;
+        }
+
+        template <typename T>
+        Pool<T> &getPool()
+        {
+            const uint32_t id = typeId<T>();
+            if (id >= pools.size())
+            {
+                pools.resize(id + 1);
+            }
+            if (!pools[id])
+            {
+                pools[id] = std::make_unique<Pool<T>>();
+            }
+            return *static_cast<Pool<T> *>(pools[id].get());
+        }
+
+        // Indexed by typeId(), null for types never added to this registry
+        std::vector<std::unique_ptr<PoolBase>> pools;
+
+        // Bumped on destroy, so only handles from the latest create() match
+        std::vector<uint32_t> generations;
+        std::vector<uint32_t> freeIndices;
+        uint32_t entityCount = 0;
+    };
+}
@@ -1,50 +1,192 @@
 #include "SimpleRenderSystem.hpp"
 
+#include "Platform/SwapChain.hpp"
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
 #include <stdexcept>
+#include <thread>
 
 namespace VoxelEngine
 {
 
-    struct SimplePushConstantData
-    {
-        glm::mat4 modelMatrix{1.f};
-        glm::mat4 normalMatrix{1.f};
-    };
+    constexpr const char *VERTEX_SHADER_PATH = "../Resources/Shaders/VertexShader.vert";
+    constexpr const char *PACKED_VERTEX_SHADER_PATH = "../Resources/Shaders/PackedVertexShader.vert";
+    constexpr const char *FRAGMENT_SHADER_PATH = "../Resources/Shaders/FragmentShader.frag";
 
-    SimpleRenderSystem::SimpleRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : device{device}
+    SimpleRenderSystem::SimpleRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, JobSystem &jobSystem, TransformPool &transforms)
+        : device{device}, jobSystem{jobSystem}, objectCuller{transforms}
     {
+        createDescriptorSets();
         createPipelineLayout(globalSetLayout);
         createPipeline(renderPass);
+
+        shaderWatcher.watch(VERTEX_SHADER_PATH);
+        shaderWatcher.watch(PACKED_VERTEX_SHADER_PATH);
+        shaderWatcher.watch(FRAGMENT_SHADER_PATH);
     }
 
     SimpleRenderSystem::~SimpleRenderSystem()
     {
+        // A running rebuild still uses the pipeline layout
+        while (shaderReload && !shaderReload->done.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
         vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
     }
 
-    void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+    void SimpleRenderSystem::createDescriptorSets()
+    {
+        descriptorPool = DescriptorPool::Builder(device)
+            .setMaxSets(2 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .build();
+
+        objectSetLayout = DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .build();
+
+        createObjectBuffer(objectBuffer);
+        createObjectBuffer(chunkBuffer);
+    }
+
+    void SimpleRenderSystem::createObjectBuffer(ObjectBuffer &objectBuffer)
+    {
+        objectBuffer.buffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        objectBuffer.descriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            objectBuffer.buffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(ObjectData),
+                INITIAL_OBJECT_CAPACITY,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            objectBuffer.buffers[i]->map();
+
+            auto bufferInfo = objectBuffer.buffers[i]->descriptorInfo();
+            DescriptorWriter(*objectSetLayout, *descriptorPool)
+                .writeBuffer(0, &bufferInfo)
+                .build(objectBuffer.descriptorSets[i]);
+        }
+    }
+
+    VkDescriptorSet SimpleRenderSystem::uploadObjectData(FrameInfo &frameInfo, ObjectBuffer &objectBuffer)
+    {
+        const int frameIndex = frameInfo.frameIndex;
+        auto &buffer = objectBuffer.buffers[frameIndex];
+
+        // The frame that last used this slot has finished, so its buffer can be replaced
+        if (stagedObjects.size() > buffer->getInstanceCount())
+        {
+            uint32_t capacity = buffer->getInstanceCount();
+            while (capacity < stagedObjects.size())
+            {
+                capacity *= 2;
+            }
+
+            buffer = std::make_unique<Buffer>(
+                device,
+                sizeof(ObjectData),
+                capacity,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            buffer->map();
+
+            auto bufferInfo = buffer->descriptorInfo();
+            DescriptorWriter(*objectSetLayout, *descriptorPool)
+                .writeBuffer(0, &bufferInfo)
+                .overwrite(objectBuffer.descriptorSets[frameIndex]);
+        }
+
+        if (!stagedObjects.empty())
+        {
+            std::memcpy(buffer->getMappedMemory(), stagedObjects.data(), stagedObjects.size() * sizeof(ObjectData));
+        }
+        return objectBuffer.descriptorSets[frameIndex];
+    }
+
+    void SimpleRenderSystem::bindDescriptorSets(VkCommandBuffer commandBuffer, FrameInfo &frameInfo, VkDescriptorSet objectSet)
+    {
+        VkDescriptorSet descriptorSets[] = {frameInfo.globalDescriptorSet, objectSet};
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0, 2,
+            descriptorSets,
+            0, nullptr);
+    }
+
+    void SimpleRenderSystem::recordDraws(FrameInfo &frameInfo, Renderer &renderer, uint32_t recordingThreads, uint32_t drawCount, const RecordFunction &record)
     {
+        if (recordingThreads == 0)
+        {
+            record(frameInfo.commandBuffer, 0, drawCount);
+            return;
+        }
 
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(SimplePushConstantData);
+        // Partitions are claimed by whichever thread gets to them first, this one included, so
+        // busy workers only cost parallelism. A job that starts after every partition is claimed
+        // returns without touching anything but the shared counters
+        struct Progress
+        {
+            std::atomic<uint32_t> nextPartition{0};
+            std::atomic<uint32_t> recordedPartitions{0};
+        };
+        const uint32_t partitionCount = std::min(recordingThreads, Renderer::MAX_RECORDING_SLOTS);
+        auto progress = std::make_shared<Progress>();
+        secondaryCommandBuffers.assign(partitionCount, VK_NULL_HANDLE);
+
+        auto recordPartitions = [this, &renderer, &record, progress, partitionCount, drawCount]
+        {
+            for (uint32_t partition = progress->nextPartition++; partition < partitionCount; partition = progress->nextPartition++)
+            {
+                // The partition doubles as the recording slot, so no two threads share a command pool
+                VkCommandBuffer commandBuffer = renderer.beginSecondaryCommandBuffer(partition);
+                record(commandBuffer, drawCount * partition / partitionCount, drawCount * (partition + 1) / partitionCount);
+                renderer.endSecondaryCommandBuffer(commandBuffer);
+                secondaryCommandBuffers[partition] = commandBuffer;
+                progress->recordedPartitions.fetch_add(1, std::memory_order_release);
+            }
+        };
+
+        for (uint32_t i = 1; i < partitionCount; i++)
+        {
+            // A full queue just leaves more partitions to this thread
+            jobSystem.submit(recordPartitions, JobSystem::HIGHEST_PRIORITY);
+        }
+        recordPartitions();
+        while (progress->recordedPartitions.load(std::memory_order_acquire) < partitionCount)
+        {
+            std::this_thread::yield();
+        }
+
+        vkCmdExecuteCommands(frameInfo.commandBuffer, partitionCount, secondaryCommandBuffers.data());
+    }
 
-        std::vector<VkDescriptorSetLayout> descriptorSetLayout{globalSetLayout};
+    void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+    {
+        std::vector<VkDescriptorSetLayout> descriptorSetLayout{globalSetLayout, objectSetLayout->getDescriptorSetLayout()};
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayout.size());
         pipelineLayoutInfo.pSetLayouts = descriptorSetLayout.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
         if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
         {
@@ -56,41 +198,227 @@ namespace VoxelEngine
     {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout is created");
 
+        pipelines = buildPipelines(renderPass);
+    }
+
+    SimpleRenderSystem::PipelineSet SimpleRenderSystem::buildPipelines(VkRenderPass renderPass) const
+    {
+        PipelineSet pipelines{};
+
         PipelineConfigInfo pipelineConfig{};
         Pipeline::defaultPipelineConfigInfo(pipelineConfig);
         pipelineConfig.renderPass = renderPass;
         pipelineConfig.pipelineLayout = pipelineLayout;
-        pipeline = std::make_unique<Pipeline>(
+        pipelines.pipeline = std::make_unique<Pipeline>(
+            device,
+            VERTEX_SHADER_PATH,
+            FRAGMENT_SHADER_PATH,
+            pipelineConfig);
+
+        pipelineConfig.bindingDescriptions = Model::PackedVertex::getBindingDescriptions();
+        pipelineConfig.attributeDescriptions = Model::PackedVertex::getAttributeDescriptions();
+        pipelines.packedPipeline = std::make_unique<Pipeline>(
             device,
-            "..\\Resources\\Shaders\\VertexShader.vert.spv",
-            "..\\Resources\\Shaders\\FragmentShader.frag.spv",
+            PACKED_VERTEX_SHADER_PATH,
+            FRAGMENT_SHADER_PATH,
             pipelineConfig);
+
+        return pipelines;
     }
 
-    void SimpleRenderSystem::renderGameObjects(FrameInfo &frameInfo, std::vector<Object> &objects)
+    void SimpleRenderSystem::startShaderReload(VkRenderPass renderPass)
     {
-        pipeline->bind(frameInfo.commandBuffer);
-        
-        vkCmdBindDescriptorSets(
-            frameInfo.commandBuffer,
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            pipelineLayout,
-            0, 1,
-            &frameInfo.globalDescriptorSet,
-            0, nullptr
-        );
+        auto reload = std::make_shared<ShaderReload>();
+        const bool submitted = jobSystem.submit(
+            [this, reload, renderPass]
+            {
+                // Unchanged stages come from the ShaderManager cache, only the edited ones recompile
+                try
+                {
+                    reload->pipelines = buildPipelines(renderPass);
+                }
+                catch (const std::exception &e)
+                {
+                    reload->error = e.what();
+                }
+                reload->done.store(true, std::memory_order_release);
+            },
+            JobSystem::HIGHEST_PRIORITY);
 
-        for (auto &object : objects)
+        // A full queue leaves the reload pending for the next frame
+        if (submitted)
         {
+            shaderReload = std::move(reload);
+            shaderReloadPending = false;
+        }
+    }
 
-            SimplePushConstantData push{};
-            push.modelMatrix = object.transform.mat4();
-            push.normalMatrix = object.transform.normalMatrix();
+    void SimpleRenderSystem::reloadShaders(VkRenderPass renderPass)
+    {
+        if (!shaderWatcher.poll().empty())
+        {
+            shaderReloadPending = true;
+        }
 
-            vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
+        if (shaderReload && shaderReload->done.load(std::memory_order_acquire))
+        {
+            if (shaderReload->error.empty())
+            {
+                // Frames in flight may still be bound to the old ones
+                device.deletionQueue().push([retired = std::make_shared<PipelineSet>(std::move(pipelines))]() mutable
+                                            { retired.reset(); });
+                pipelines = std::move(shaderReload->pipelines);
+                std::cout << "[shaders] reloaded" << std::endl;
+            }
+            else
+            {
+                std::cerr << "[shaders] reload failed, keeping the previous pipelines\n" << shaderReload->error << std::endl;
+            }
+            shaderReload.reset();
+        }
 
-            object.model->bind(frameInfo.commandBuffer);
-            object.model->draw(frameInfo.commandBuffer);
+        if (shaderReloadPending && !shaderReload)
+        {
+            startShaderReload(renderPass);
         }
     }
-}
\ No newline at end of file
+
+    void SimpleRenderSystem::renderGameObjects(FrameInfo &frameInfo, Registry &registry, Renderer &renderer, uint32_t recordingThreads)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        objectCuller.update(registry);
+        objectCuller.cull(Frustum{frameInfo.camera.getProjection() * frameInfo.camera.getView()}, visibleObjects);
+
+        const auto culled = std::chrono::high_resolution_clock::now();
+
+        drawOrder.clear();
+        for (Entity entity : visibleObjects)
+        {
+            drawOrder.emplace_back(registry.get<ModelComponent>(entity).model, entity);
+        }
+        std::sort(drawOrder.begin(), drawOrder.end(), [](const auto &a, const auto &b)
+        {
+            if (a.first->getVertexFormat() != b.first->getVertexFormat())
+            {
+                return a.first->getVertexFormat() < b.first->getVertexFormat();
+            }
+            return a.first != b.first ? std::less<Model *>{}(a.first, b.first) : a.second.index < b.second.index;
+        });
+
+        stagedObjects.resize(drawOrder.size());
+        drawGroups.clear();
+        for (size_t i = 0; i < drawOrder.size(); i++)
+        {
+            const Entity entity = drawOrder[i].second;
+            ObjectData &data = stagedObjects[i];
+            data.modelMatrix = objectCuller.getWorldMatrix(entity);
+            const glm::mat4 &normalMatrix = objectCuller.getNormalMatrix(entity);
+            data.normalMatrix[0] = normalMatrix[0];
+            data.normalMatrix[1] = normalMatrix[1];
+            data.normalMatrix[2] = normalMatrix[2];
+            if (const MaterialComponent *material = registry.tryGet<MaterialComponent>(entity))
+            {
+                data.color = glm::vec4{material->color, 1.f};
+                data.materialId = material->materialId;
+            }
+            else
+            {
+                data.color = glm::vec4{1.f};
+                data.materialId = 0;
+            }
+
+            // Every run sharing a model becomes one instanced draw
+            Model *model = drawOrder[i].first;
+            if (drawGroups.empty() || drawGroups.back().model != model)
+            {
+                drawGroups.push_back({model, static_cast<uint32_t>(i), 0});
+            }
+            drawGroups.back().instanceCount++;
+        }
+        const VkDescriptorSet objectSet = uploadObjectData(frameInfo, objectBuffer);
+
+        recordDraws(frameInfo, renderer, recordingThreads, static_cast<uint32_t>(drawGroups.size()),
+            [&](VkCommandBuffer commandBuffer, uint32_t firstGroup, uint32_t endGroup)
+            {
+                if (firstGroup == endGroup)
+                {
+                    return;
+                }
+
+                // Both pipelines share the layout, so the descriptor sets survive switching between them
+                Model::VertexFormat boundFormat = drawGroups[firstGroup].model->getVertexFormat();
+                (boundFormat == Model::VertexFormat::Packed ? pipelines.packedPipeline : pipelines.pipeline)->bind(commandBuffer);
+                bindDescriptorSets(commandBuffer, frameInfo, objectSet);
+
+                for (uint32_t i = firstGroup; i < endGroup; i++)
+                {
+                    const DrawGroup &group = drawGroups[i];
+                    if (group.model->getVertexFormat() != boundFormat)
+                    {
+                        boundFormat = group.model->getVertexFormat();
+                        (boundFormat == Model::VertexFormat::Packed ? pipelines.packedPipeline : pipelines.pipeline)->bind(commandBuffer);
+                    }
+
+                    group.model->bind(commandBuffer);
+                    group.model->draw(commandBuffer, group.instanceCount, group.firstInstance);
+                }
+            });
+
+        const auto end = std::chrono::high_resolution_clock::now();
+        lastObjectStats = RenderStats{};
+        lastObjectStats.candidateCount = objectCuller.getObjectCount();
+        lastObjectStats.drawCount = static_cast<uint32_t>(visibleObjects.size());
+        lastObjectStats.drawCalls = static_cast<uint32_t>(drawGroups.size());
+        lastObjectStats.cullMicroseconds = std::chrono::duration<double, std::micro>(culled - start).count();
+        lastObjectStats.recordMicroseconds = std::chrono::duration<double, std::micro>(end - start).count();
+    }
+
+    void SimpleRenderSystem::renderChunks(FrameInfo &frameInfo, ChunkManager &chunkManager, Renderer &renderer, uint32_t recordingThreads)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        lastChunkStats = RenderStats{};
+
+        ObjectData data{};
+        const glm::mat4 normalMatrix = ChunkManager::getNormalMatrix();
+        data.normalMatrix[0] = normalMatrix[0];
+        data.normalMatrix[1] = normalMatrix[1];
+        data.normalMatrix[2] = normalMatrix[2];
+
+        // Each chunk's ObjectData entry sits at the same index as its mesh
+        stagedObjects.clear();
+        chunkMeshes.clear();
+        chunkManager.forEachMesh([&](const glm::ivec3 &chunkCoord, const MeshArena::Mesh &mesh)
+        {
+            data.modelMatrix = ChunkManager::getModelMatrix(chunkCoord);
+            stagedObjects.push_back(data);
+            chunkMeshes.push_back(mesh);
+        });
+        const VkDescriptorSet objectSet = uploadObjectData(frameInfo, chunkBuffer);
+
+        recordDraws(frameInfo, renderer, recordingThreads, static_cast<uint32_t>(chunkMeshes.size()),
+            [&](VkCommandBuffer commandBuffer, uint32_t firstMesh, uint32_t endMesh)
+            {
+                if (firstMesh == endMesh)
+                {
+                    return;
+                }
+
+                pipelines.packedPipeline->bind(commandBuffer);
+                bindDescriptorSets(commandBuffer, frameInfo, objectSet);
+
+                // Every chunk shares the arena buffers, so they are bound once per command buffer
+                chunkManager.getArena().bind(commandBuffer);
+                for (uint32_t i = firstMesh; i < endMesh; i++)
+                {
+                    MeshArena::draw(commandBuffer, chunkMeshes[i], i);
+                }
+            });
+
+        const auto end = std::chrono::high_resolution_clock::now();
+        lastChunkStats.drawCount = static_cast<uint32_t>(chunkMeshes.size());
+        lastChunkStats.candidateCount = lastChunkStats.drawCount;
+        lastChunkStats.drawCalls = lastChunkStats.drawCount;
+        lastChunkStats.recordMicroseconds = std::chrono::duration<double, std::micro>(end - start).count();
+    }
+}
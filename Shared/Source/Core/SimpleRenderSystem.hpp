@@ -1,34 +1,148 @@
 #pragma once
 
 #include "Platform/Device.hpp"
+#include "Platform/Buffer.hpp"
+#include "Platform/Descriptors.hpp"
 #include "Platform/Pipeline.hpp"
+#include "Platform/Renderer.hpp"
 #include "FrameInfo.hpp"
 #include "Camera.hpp"
-#include "Object.hpp"
+#include "JobSystem.hpp"
+#include "Registry.hpp"
+#include "ObjectCuller.hpp"
+#include "Utils/FileWatcher.hpp"
+#include "World/ChunkManager.hpp"
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace VoxelEngine
 {
+    // Draws models and, without the indirect terrain path, one draw per chunk.
+    //
+    // Per draw data goes into a per-frame storage buffer of ObjectData written once per frame, and
+    // each draw picks its entry through firstInstance, so nothing is pushed between draws.
+    // Visible objects are sorted by vertex format and model, and every run sharing a model is one
+    // instanced draw over consecutive ObjectData entries.
+    //
+    // Draws are recorded straight into the frame's command buffer, or split into ranges that are
+    // recorded in parallel into secondary command buffers, one per recording thread.
+    //
+    // The shader sources are watched while running. An edit rebuilds both pipelines in a job and
+    // the new ones replace the old at the start of a later frame, the old ones are destroyed once
+    // no frame in flight can still be using them. A shader that fails to compile keeps the old.
     class SimpleRenderSystem
     {
     public:
-        SimpleRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        static constexpr uint32_t INITIAL_OBJECT_CAPACITY = 1024;
+
+        SimpleRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, JobSystem &jobSystem, TransformPool &transforms);
         ~SimpleRenderSystem();
 
         SimpleRenderSystem(const SimpleRenderSystem &) = delete;
         SimpleRenderSystem &operator=(const SimpleRenderSystem &) = delete;
 
-        void renderGameObjects(FrameInfo &frameInfo, std::vector<Object> &objects);
+        // Once per frame after beginFrame and before recording, the frame boundary where finished
+        // rebuilds are swapped in. renderPass is the current one, new pipelines are built against it
+        void reloadShaders(VkRenderPass renderPass);
+
+        // recordingThreads 0 records inline. Otherwise the render pass must have been begun with
+        // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, up to Renderer::MAX_RECORDING_SLOTS
+        void renderGameObjects(FrameInfo &frameInfo, Registry &registry, Renderer &renderer, uint32_t recordingThreads = 0);
+        void renderChunks(FrameInfo &frameInfo, ChunkManager &chunkManager, Renderer &renderer, uint32_t recordingThreads = 0);
+
+        const RenderStats &getLastObjectStats() const { return lastObjectStats; }
+        const RenderStats &getLastChunkStats() const { return lastChunkStats; }
 
     private:
+        // Matches ObjectData in VertexShader.vert and PackedVertexShader.vert, std430
+        struct ObjectData
+        {
+            glm::mat4 modelMatrix{1.f};
+            glm::vec4 normalMatrix[3]{}; // mat3 columns, w unused
+            glm::vec4 color{1.f};
+            uint32_t materialId = 0;
+            uint32_t padding[3]{};
+        };
+        static_assert(sizeof(ObjectData) == 144, "ObjectData must match the std430 layout in the shaders");
+
+        // One pipeline per Model::VertexFormat
+        struct PipelineSet
+        {
+            std::unique_ptr<Pipeline> pipeline;
+            std::unique_ptr<Pipeline> packedPipeline;
+        };
+
+        // Written by the rebuild job, read by the render thread once done is set
+        struct ShaderReload
+        {
+            PipelineSet pipelines;
+            std::string error;
+            std::atomic<bool> done{false};
+        };
+
+        // Consecutive drawOrder entries sharing a model
+        struct DrawGroup
+        {
+            Model *model;
+            uint32_t firstInstance;
+            uint32_t instanceCount;
+        };
+
+        // Records draws [first, end) into the command buffer
+        using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t end)>;
+
+        // One buffer and descriptor set per frame in flight, grown when a frame needs more
+        struct ObjectBuffer
+        {
+            std::vector<std::unique_ptr<Buffer>> buffers;
+            std::vector<VkDescriptorSet> descriptorSets;
+        };
+
+        void createDescriptorSets();
+        void createObjectBuffer(ObjectBuffer &objectBuffer);
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
         void createPipeline(VkRenderPass renderPass);
+        // Only reads the layout, so it is safe on a worker thread
+        PipelineSet buildPipelines(VkRenderPass renderPass) const;
+        void startShaderReload(VkRenderPass renderPass);
+        // Copies stagedObjects into the frame's buffer and returns its descriptor set
+        VkDescriptorSet uploadObjectData(FrameInfo &frameInfo, ObjectBuffer &objectBuffer);
+        void bindDescriptorSets(VkCommandBuffer commandBuffer, FrameInfo &frameInfo, VkDescriptorSet objectSet);
+        // Runs record over [0, drawCount) inline, or over one range per thread into secondary
+        // buffers that are then executed in order
+        void recordDraws(FrameInfo &frameInfo, Renderer &renderer, uint32_t recordingThreads, uint32_t drawCount, const RecordFunction &record);
 
         Device &device;
+        JobSystem &jobSystem;
+
+        std::unique_ptr<DescriptorPool> descriptorPool;
+        std::unique_ptr<DescriptorSetLayout> objectSetLayout;
+        // Separate buffers so each render call owns its frame's entries whatever the call order
+        ObjectBuffer objectBuffer;
+        ObjectBuffer chunkBuffer;
+        std::vector<ObjectData> stagedObjects;
 
-        std::unique_ptr<Pipeline> pipeline;
+        PipelineSet pipelines;
         VkPipelineLayout pipelineLayout;
+
+        FileWatcher shaderWatcher;
+        // Set by an edit until a rebuild picks it up, edits made during a rebuild start another
+        bool shaderReloadPending = false;
+        std::shared_ptr<ShaderReload> shaderReload;
+
+        ObjectCuller objectCuller;
+        std::vector<Entity> visibleObjects;
+        // Visible objects in draw order, grouped by pipeline and then model
+        std::vector<std::pair<Model *, Entity>> drawOrder;
+        std::vector<DrawGroup> drawGroups;
+        std::vector<MeshArena::Mesh> chunkMeshes;
+        std::vector<VkCommandBuffer> secondaryCommandBuffers;
+
+        RenderStats lastObjectStats{};
+        RenderStats lastChunkStats{};
     };
 }
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "TerrainRenderSystem.hpp"
+
+#include "Platform/SwapChain.hpp"
+#include "Frustum.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+
+namespace VoxelEngine
+{
+    TerrainRenderSystem::TerrainRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : device{device}, depthPyramid{device}
+    {
+        createBuffers();
+        createDescriptorSets();
+        createPipelineLayouts(globalSetLayout);
+        createPipelines(renderPass);
+    }
+
+    TerrainRenderSystem::~TerrainRenderSystem()
+    {
+        vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+        vkDestroyPipelineLayout(device.device(), cullPipelineLayout, nullptr);
+    }
+
+    void TerrainRenderSystem::createBuffers()
+    {
+        candidateBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        drawDataBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        visibleBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        visibleCountBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        cullUniformBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        candidateCounts.resize(SwapChain::MAX_FRAMES_IN_FLIGHT, 0);
+        pyramidDescriptorStale.resize(SwapChain::MAX_FRAMES_IN_FLIGHT, true);
+        for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            candidateBuffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(VkDrawIndexedIndirectCommand),
+                MAX_DRAWS,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            candidateBuffers[i]->map();
+
+            drawDataBuffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(ChunkDrawData),
+                MAX_DRAWS,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            drawDataBuffers[i]->map();
+
+            // Only the GPU writes the visible draws, it is cleared before every cull
+            visibleBuffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(VkDrawIndexedIndirectCommand),
+                MAX_DRAWS,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            // Host-visible so the stats can read back how many draws survived
+            visibleCountBuffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(uint32_t),
+                1,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            visibleCountBuffers[i]->map();
+
+            cullUniformBuffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(CullUniforms),
+                1,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            cullUniformBuffers[i]->map();
+        }
+    }
+
+    void TerrainRenderSystem::createDescriptorSets()
+    {
+        descriptorPool = DescriptorPool::Builder(device)
+            .setMaxSets(2 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .build();
+
+        drawSetLayout = DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .build();
+
+        cullSetLayout = DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build();
+
+        drawDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        cullDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            auto drawDataInfo = drawDataBuffers[i]->descriptorInfo();
+            DescriptorWriter(*drawSetLayout, *descriptorPool)
+                .writeBuffer(0, &drawDataInfo)
+                .build(drawDescriptorSets[i]);
+
+            // The depth pyramid (binding 5) is written once it exists, see writePyramidDescriptor
+            auto uniformInfo = cullUniformBuffers[i]->descriptorInfo();
+            auto candidateInfo = candidateBuffers[i]->descriptorInfo();
+            auto visibleInfo = visibleBuffers[i]->descriptorInfo();
+            auto visibleCountInfo = visibleCountBuffers[i]->descriptorInfo();
+            DescriptorWriter(*cullSetLayout, *descriptorPool)
+                .writeBuffer(0, &uniformInfo)
+                .writeBuffer(1, &candidateInfo)
+                .writeBuffer(2, &drawDataInfo)
+                .writeBuffer(3, &visibleInfo)
+                .writeBuffer(4, &visibleCountInfo)
+                .build(cullDescriptorSets[i]);
+        }
+    }
+
+    void TerrainRenderSystem::writePyramidDescriptor(int frameIndex)
+    {
+        auto pyramidInfo = depthPyramid.descriptorInfo();
+        DescriptorWriter(*cullSetLayout, *descriptorPool)
+            .writeImage(5, &pyramidInfo)
+            .overwrite(cullDescriptorSets[frameIndex]);
+        pyramidDescriptorStale[frameIndex] = false;
+    }
+
+    void TerrainRenderSystem::createPipelineLayouts(VkDescriptorSetLayout globalSetLayout)
+    {
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, drawSetLayout->getDescriptorSetLayout()};
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+        if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create terrain pipeline layout!");
+        }
+
+        VkDescriptorSetLayout cullLayout = cullSetLayout->getDescriptorSetLayout();
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &cullLayout;
+
+        if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create terrain cull pipeline layout!");
+        }
+    }
+
+    void TerrainRenderSystem::createPipelines(VkRenderPass renderPass)
+    {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout is created");
+
+        PipelineConfigInfo pipelineConfig{};
+        Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+        pipelineConfig.bindingDescriptions = Model::PackedVertex::getBindingDescriptions();
+        pipelineConfig.attributeDescriptions = Model::PackedVertex::getAttributeDescriptions();
+        pipelineConfig.renderPass = renderPass;
+        pipelineConfig.pipelineLayout = pipelineLayout;
+        pipeline = std::make_unique<Pipeline>(
+            device,
+            "../Resources/Shaders/TerrainShader.vert",
+            "../Resources/Shaders/FragmentShader.frag",
+            pipelineConfig);
+
+        cullPipeline = std::make_unique<ComputePipeline>(device, "../Resources/Shaders/ChunkCull.comp", cullPipelineLayout);
+    }
+
+    void TerrainRenderSystem::cull(FrameInfo &frameInfo, ChunkManager &chunkManager, VkExtent2D depthExtent)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        const int frameIndex = frameInfo.frameIndex;
+
+        if (depthPyramid.resize(frameInfo.commandBuffer, depthExtent))
+        {
+            // Other slots may still be in flight with the old pyramid, they catch up on their next turn
+            std::fill(pyramidDescriptorStale.begin(), pyramidDescriptorStale.end(), true);
+            pyramidReady = false;
+        }
+        if (pyramidDescriptorStale[frameIndex])
+        {
+            writePyramidDescriptor(frameIndex);
+        }
+
+        // This slot's last frame has finished, so its count is final
+        lastStats = RenderStats{};
+        lastStats.candidateCount = candidateCounts[frameIndex];
+        lastStats.drawCount = *static_cast<const uint32_t *>(visibleCountBuffers[frameIndex]->getMappedMemory());
+
+        auto *commands = static_cast<VkDrawIndexedIndirectCommand *>(candidateBuffers[frameIndex]->getMappedMemory());
+        auto *drawData = static_cast<ChunkDrawData *>(drawDataBuffers[frameIndex]->getMappedMemory());
+
+        uint32_t drawCount = 0;
+        chunkManager.forEachMesh([&](const glm::ivec3 &chunkCoord, const MeshArena::Mesh &mesh)
+        {
+            if (drawCount == MAX_DRAWS)
+            {
+                return;
+            }
+
+            VkDrawIndexedIndirectCommand &command = commands[drawCount];
+            command.indexCount = mesh.indexCount;
+            command.instanceCount = 1;
+            command.firstIndex = mesh.firstIndex;
+            command.vertexOffset = mesh.vertexOffset;
+            command.firstInstance = drawCount;
+
+            drawData[drawCount].origin = glm::vec4{glm::vec3{chunkCoord * Chunk::SIZE}, 0.f};
+            drawCount++;
+        });
+        candidateCounts[frameIndex] = drawCount;
+
+        CullUniforms uniforms{};
+        Frustum::extractPlanes(frameInfo.camera.getProjection() * frameInfo.camera.getView(), uniforms.frustumPlanes);
+        uniforms.previousProjectionView = pyramidProjectionView;
+        uniforms.pyramidSize = glm::vec2{depthPyramid.getExtent().width, depthPyramid.getExtent().height};
+        uniforms.drawCount = drawCount;
+        uniforms.occlusionEnabled = pyramidReady ? 1 : 0;
+        uniforms.chunkSize = static_cast<float>(Chunk::SIZE);
+        cullUniformBuffers[frameIndex]->writeToBuffer(&uniforms);
+        pyramidReady = false;
+
+        // Zeroed commands past the visible count draw nothing when the count cannot come from a buffer
+        VkBuffer visibleBuffer = visibleBuffers[frameIndex]->getBuffer();
+        VkBuffer visibleCountBuffer = visibleCountBuffers[frameIndex]->getBuffer();
+        vkCmdFillBuffer(frameInfo.commandBuffer, visibleBuffer, 0, VK_WHOLE_SIZE, 0);
+        vkCmdFillBuffer(frameInfo.commandBuffer, visibleCountBuffer, 0, VK_WHOLE_SIZE, 0);
+
+        VkMemoryBarrier clearBarrier{};
+        clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        // The pyramid was written by the last frame's reduction
+        VkImageMemoryBarrier pyramidBarrier{};
+        pyramidBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        pyramidBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        pyramidBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        pyramidBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        pyramidBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        pyramidBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        pyramidBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        pyramidBarrier.image = depthPyramid.getImage();
+        pyramidBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, depthPyramid.getLevelCount(), 0, 1};
+
+        vkCmdPipelineBarrier(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &clearBarrier, 0, nullptr, 1, &pyramidBarrier);
+
+        if (drawCount > 0)
+        {
+            cullPipeline->bind(frameInfo.commandBuffer);
+            vkCmdBindDescriptorSets(
+                frameInfo.commandBuffer,
+                VK_PIPELINE_BIND_POINT_COMPUTE,
+                cullPipelineLayout,
+                0, 1,
+                &cullDescriptorSets[frameIndex],
+                0, nullptr);
+            vkCmdDispatch(frameInfo.commandBuffer, (drawCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+        }
+
+        VkMemoryBarrier cullBarrier{};
+        cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(
+            frameInfo.commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+
+        const auto end = std::chrono::high_resolution_clock::now();
+        lastStats.recordMicroseconds = std::chrono::duration<double, std::micro>(end - start).count();
+    }
+
+    void TerrainRenderSystem::render(FrameInfo &frameInfo, ChunkManager &chunkManager)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        const uint32_t candidateCount = candidateCounts[frameInfo.frameIndex];
+        if (candidateCount > 0)
+        {
+            pipeline->bind(frameInfo.commandBuffer);
+
+            VkDescriptorSet descriptorSets[] = {frameInfo.globalDescriptorSet, drawDescriptorSets[frameInfo.frameIndex]};
+            vkCmdBindDescriptorSets(
+                frameInfo.commandBuffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                pipelineLayout,
+                0, 2,
+                descriptorSets,
+                0, nullptr
+            );
+
+            chunkManager.getArena().bind(frameInfo.commandBuffer);
+
+            VkBuffer visibleBuffer = visibleBuffers[frameInfo.frameIndex]->getBuffer();
+            constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+            if (auto drawIndexedIndirectCount = device.cmdDrawIndexedIndirectCount())
+            {
+                drawIndexedIndirectCount(frameInfo.commandBuffer, visibleBuffer, 0, visibleCountBuffers[frameInfo.frameIndex]->getBuffer(), 0, candidateCount, stride);
+                lastStats.drawCalls = 1;
+            }
+            else if (device.enabledFeatures().multiDrawIndirect)
+            {
+                vkCmdDrawIndexedIndirect(frameInfo.commandBuffer, visibleBuffer, 0, candidateCount, stride);
+                lastStats.drawCalls = 1;
+            }
+            else
+            {
+                for (uint32_t i = 0; i < candidateCount; i++)
+                {
+                    vkCmdDrawIndexedIndirect(frameInfo.commandBuffer, visibleBuffer, i * stride, 1, stride);
+                }
+                lastStats.drawCalls = candidateCount;
+            }
+        }
+
+        const auto end = std::chrono::high_resolution_clock::now();
+        lastStats.recordMicroseconds += std::chrono::duration<double, std::micro>(end - start).count();
+    }
+
+    void TerrainRenderSystem::buildDepthPyramid(FrameInfo &frameInfo, VkImage depthImage, VkImageView depthImageView, VkFormat depthFormat)
+    {
+        depthPyramid.build(frameInfo.commandBuffer, frameInfo.frameIndex, depthImage, depthImageView, depthFormat);
+        pyramidProjectionView = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+        pyramidReady = true;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Platform/Device.hpp"
+#include "Platform/Buffer.hpp"
+#include "Platform/ComputePipeline.hpp"
+#include "Platform/Descriptors.hpp"
+#include "Platform/Pipeline.hpp"
+#include "World/ChunkManager.hpp"
+#include "DepthPyramid.hpp"
+#include "FrameInfo.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Draws all terrain from the mesh arena with indirect draws, culled on the GPU.
+    //
+    // Every frame the chunk meshes are written as candidate VkDrawIndexedIndirectCommands, with
+    // the per-draw chunk origin in a storage buffer that the vertex shader indexes by firstInstance.
+    // cull() runs a compute pass that tests each chunk against the camera frustum and against the
+    // depth pyramid of the previous frame, and packs the survivors at the front of the visible
+    // buffer. render() then draws them with one vkCmdDrawIndexedIndirect(Count) call, or one per
+    // candidate without multiDrawIndirect.
+    //
+    // Per frame: cull() before the render pass, render() inside it, buildDepthPyramid() after it.
+    class TerrainRenderSystem
+    {
+    public:
+        static constexpr uint32_t MAX_DRAWS = 16384;
+        static constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+        // Needs drawIndirectFirstInstance, without it firstInstance cannot carry the draw index
+        static bool isSupported(Device &device) { return device.enabledFeatures().drawIndirectFirstInstance; }
+
+        TerrainRenderSystem(Device &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        ~TerrainRenderSystem();
+
+        TerrainRenderSystem(const TerrainRenderSystem &) = delete;
+        TerrainRenderSystem &operator=(const TerrainRenderSystem &) = delete;
+
+        void cull(FrameInfo &frameInfo, ChunkManager &chunkManager, VkExtent2D depthExtent);
+        void render(FrameInfo &frameInfo, ChunkManager &chunkManager);
+        void buildDepthPyramid(FrameInfo &frameInfo, VkImage depthImage, VkImageView depthImageView, VkFormat depthFormat);
+
+        // drawCount is the visible count of the last finished frame in the same slot
+        const RenderStats &getLastStats() const { return lastStats; }
+
+    private:
+        struct ChunkDrawData
+        {
+            glm::vec4 origin{0.f}; // chunk origin in voxel space, w unused
+        };
+
+        // Matches CullUniforms in ChunkCull.comp
+        struct CullUniforms
+        {
+            glm::vec4 frustumPlanes[6];
+            glm::mat4 previousProjectionView{1.f};
+            glm::vec2 pyramidSize{0.f};
+            uint32_t drawCount = 0;
+            uint32_t occlusionEnabled = 0;
+            float chunkSize = 0.f;
+        };
+
+        void createBuffers();
+        void createDescriptorSets();
+        void createPipelineLayouts(VkDescriptorSetLayout globalSetLayout);
+        void createPipelines(VkRenderPass renderPass);
+        void writePyramidDescriptor(int frameIndex);
+
+        Device &device;
+
+        // One set per frame in flight, the CPU writes them while older frames are still drawn
+        std::vector<std::unique_ptr<Buffer>> candidateBuffers;
+        std::vector<std::unique_ptr<Buffer>> drawDataBuffers;
+        std::vector<std::unique_ptr<Buffer>> visibleBuffers;
+        std::vector<std::unique_ptr<Buffer>> visibleCountBuffers;
+        std::vector<std::unique_ptr<Buffer>> cullUniformBuffers;
+        std::vector<uint32_t> candidateCounts;
+
+        std::unique_ptr<DescriptorPool> descriptorPool;
+        std::unique_ptr<DescriptorSetLayout> drawSetLayout;
+        std::unique_ptr<DescriptorSetLayout> cullSetLayout;
+        std::vector<VkDescriptorSet> drawDescriptorSets;
+        std::vector<VkDescriptorSet> cullDescriptorSets;
+
+        std::unique_ptr<Pipeline> pipeline;
+        VkPipelineLayout pipelineLayout;
+        std::unique_ptr<ComputePipeline> cullPipeline;
+        VkPipelineLayout cullPipelineLayout;
+
+        DepthPyramid depthPyramid;
+        // Camera of the frame the pyramid was built from, only valid when that was the last frame
+        glm::mat4 pyramidProjectionView{1.f};
+        bool pyramidReady = false;
+        // Per frame in flight, binding 5 of its cull set still points at a pyramid that was replaced
+        std::vector<bool> pyramidDescriptorStale;
+
+        RenderStats lastStats{};
+    };
+}
@@ -0,0 +1,187 @@
+#include "TransformPool.hpp"
+
+#include "Utils/SimdMath.hpp"
+
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+namespace VoxelEngine
+{
+    TransformPool::Handle TransformPool::create(const TransformComponent &transform)
+    {
+        Handle handle;
+        if (!freeHandles.empty())
+        {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        }
+        else
+        {
+            if (used == capacity)
+            {
+                grow();
+            }
+            handle = used++;
+        }
+
+        count++;
+        set(handle, transform);
+        return handle;
+    }
+
+    void TransformPool::destroy(Handle handle)
+    {
+        assert(handle < used && "Destroying an invalid transform handle");
+
+        // Reset to identity so the slot never feeds a zero scale into the normal matrix
+        set(handle, TransformComponent{});
+        dirtyBits[handle / 64] &= ~(1ull << (handle % 64));
+        freeHandles.push_back(handle);
+        count--;
+    }
+
+    void TransformPool::grow()
+    {
+        capacity = capacity == 0 ? 64 : capacity * 2;
+
+        for (auto *lane : {&translationX, &translationY, &translationZ, &rotationX, &rotationY, &rotationZ})
+        {
+            lane->resize(capacity, 0.f);
+        }
+        for (auto *lane : {&scaleX, &scaleY, &scaleZ})
+        {
+            lane->resize(capacity, 1.f);
+        }
+        worldMatrices.resize(capacity, glm::mat4{1.f});
+        normalMatrices.resize(capacity, glm::mat4{1.f});
+        dirtyBits.resize(capacity / 64, 0);
+    }
+
+    void TransformPool::set(Handle handle, const TransformComponent &transform)
+    {
+        setTranslation(handle, transform.translation);
+        setRotation(handle, transform.rotation);
+        setScale(handle, transform.scale);
+    }
+
+    void TransformPool::setTranslation(Handle handle, const glm::vec3 &translation)
+    {
+        translationX[handle] = translation.x;
+        translationY[handle] = translation.y;
+        translationZ[handle] = translation.z;
+        markDirty(handle);
+    }
+
+    void TransformPool::setRotation(Handle handle, const glm::vec3 &rotation)
+    {
+        rotationX[handle] = rotation.x;
+        rotationY[handle] = rotation.y;
+        rotationZ[handle] = rotation.z;
+        markDirty(handle);
+    }
+
+    void TransformPool::setScale(Handle handle, const glm::vec3 &scale)
+    {
+        scaleX[handle] = scale.x;
+        scaleY[handle] = scale.y;
+        scaleZ[handle] = scale.z;
+        markDirty(handle);
+    }
+
+    TransformComponent TransformPool::get(Handle handle) const
+    {
+        TransformComponent transform{};
+        transform.translation = {translationX[handle], translationY[handle], translationZ[handle]};
+        transform.rotation = {rotationX[handle], rotationY[handle], rotationZ[handle]};
+        transform.scale = {scaleX[handle], scaleY[handle], scaleZ[handle]};
+        return transform;
+    }
+
+    void TransformPool::updateMatrices()
+    {
+        for (uint32_t word = 0; word < dirtyBits.size(); word++)
+        {
+            uint64_t bits = dirtyBits[word];
+            while (bits != 0)
+            {
+                // Groups never straddle a word, 64 is a multiple of GROUP_SIZE
+                const uint32_t bit = static_cast<uint32_t>(std::countr_zero(bits)) & ~(GROUP_SIZE - 1);
+                updateGroup(word * 64 + bit);
+                bits &= ~(((1ull << GROUP_SIZE) - 1) << bit);
+            }
+            dirtyBits[word] = 0;
+        }
+    }
+
+#ifdef VOXEL_ENGINE_SSE2
+    // Same matrices as TransformComponent::mat4() and normalMatrix(), for four entries at once
+    void TransformPool::updateGroup(uint32_t first)
+    {
+        __m128 s1, c1, s2, c2, s3, c3;
+        sinCos4(_mm_loadu_ps(&rotationY[first]), s1, c1);
+        sinCos4(_mm_loadu_ps(&rotationX[first]), s2, c2);
+        sinCos4(_mm_loadu_ps(&rotationZ[first]), s3, c3);
+
+        // Rotation columns shared by both matrices, before scaling
+        const __m128 s2s3 = _mm_mul_ps(s2, s3);
+        const __m128 c3s2 = _mm_mul_ps(c3, s2);
+        __m128 rotation[3][3] = {
+            {_mm_add_ps(_mm_mul_ps(c1, c3), _mm_mul_ps(s1, s2s3)), _mm_mul_ps(c2, s3), _mm_sub_ps(_mm_mul_ps(c1, s2s3), _mm_mul_ps(c3, s1))},
+            {_mm_sub_ps(_mm_mul_ps(s1, c3s2), _mm_mul_ps(c1, s3)), _mm_mul_ps(c2, c3), _mm_add_ps(_mm_mul_ps(c1, c3s2), _mm_mul_ps(s1, s3))},
+            {_mm_mul_ps(c2, s1), _mm_xor_ps(s2, _mm_set1_ps(-0.f)), _mm_mul_ps(c1, c2)},
+        };
+
+        const __m128 scale[3] = {_mm_loadu_ps(&scaleX[first]), _mm_loadu_ps(&scaleY[first]), _mm_loadu_ps(&scaleZ[first])};
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+
+        for (int column = 0; column < 3; column++)
+        {
+            __m128 world[3], normal[3];
+            const __m128 inverseScale = _mm_div_ps(one, scale[column]);
+            for (int row = 0; row < 3; row++)
+            {
+                world[row] = _mm_mul_ps(rotation[column][row], scale[column]);
+                normal[row] = _mm_mul_ps(rotation[column][row], inverseScale);
+            }
+
+            // Lane i of each register belongs to entry first + i, transpose into per entry columns
+            __m128 w = zero;
+            _MM_TRANSPOSE4_PS(world[0], world[1], world[2], w);
+            _mm_storeu_ps(&worldMatrices[first + 0][column][0], world[0]);
+            _mm_storeu_ps(&worldMatrices[first + 1][column][0], world[1]);
+            _mm_storeu_ps(&worldMatrices[first + 2][column][0], world[2]);
+            _mm_storeu_ps(&worldMatrices[first + 3][column][0], w);
+
+            w = zero;
+            _MM_TRANSPOSE4_PS(normal[0], normal[1], normal[2], w);
+            _mm_storeu_ps(&normalMatrices[first + 0][column][0], normal[0]);
+            _mm_storeu_ps(&normalMatrices[first + 1][column][0], normal[1]);
+            _mm_storeu_ps(&normalMatrices[first + 2][column][0], normal[2]);
+            _mm_storeu_ps(&normalMatrices[first + 3][column][0], w);
+        }
+
+        __m128 x = _mm_loadu_ps(&translationX[first]);
+        __m128 y = _mm_loadu_ps(&translationY[first]);
+        __m128 z = _mm_loadu_ps(&translationZ[first]);
+        __m128 w = one;
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(&worldMatrices[first + 0][3][0], x);
+        _mm_storeu_ps(&worldMatrices[first + 1][3][0], y);
+        _mm_storeu_ps(&worldMatrices[first + 2][3][0], z);
+        _mm_storeu_ps(&worldMatrices[first + 3][3][0], w);
+        // The normal matrices keep the identity fourth column they were created with
+    }
+#else
+    void TransformPool::updateGroup(uint32_t first)
+    {
+        for (uint32_t handle = first; handle < first + GROUP_SIZE; handle++)
+        {
+            TransformComponent transform = get(handle);
+            worldMatrices[handle] = transform.mat4();
+            normalMatrices[handle] = glm::mat4{transform.normalMatrix()};
+        }
+    }
+#endif
+}
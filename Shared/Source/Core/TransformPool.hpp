@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Components.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Transforms stored as structure of arrays, with their world and normal matrices cached.
+    //
+    // Every component of translation, rotation and scale has its own float array, so four
+    // neighbouring transforms load as one SSE register. Setters only flag the entry as dirty;
+    // updateMatrices() then rebuilds the matrices of dirty entries four at a time and leaves the
+    // clean ones alone, so a static transform costs nothing per frame.
+    class TransformPool
+    {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle INVALID_HANDLE = UINT32_MAX;
+
+        TransformPool() = default;
+
+        TransformPool(const TransformPool &) = delete;
+        TransformPool &operator=(const TransformPool &) = delete;
+
+        Handle create(const TransformComponent &transform = {});
+        void destroy(Handle handle);
+
+        void set(Handle handle, const TransformComponent &transform);
+        void setTranslation(Handle handle, const glm::vec3 &translation);
+        void setRotation(Handle handle, const glm::vec3 &rotation);
+        void setScale(Handle handle, const glm::vec3 &scale);
+        TransformComponent get(Handle handle) const;
+        glm::vec3 getTranslation(Handle handle) const { return {translationX[handle], translationY[handle], translationZ[handle]}; }
+        glm::vec3 getRotation(Handle handle) const { return {rotationX[handle], rotationY[handle], rotationZ[handle]}; }
+        glm::vec3 getScale(Handle handle) const { return {scaleX[handle], scaleY[handle], scaleZ[handle]}; }
+
+        // Rebuilds the cached matrices of every entry changed since the last call
+        void updateMatrices();
+
+        // Only current after updateMatrices()
+        const glm::mat4 &getWorldMatrix(Handle handle) const { return worldMatrices[handle]; }
+        // Inverse scale rotation in the upper 3x3, written to ObjectData as three vec4 columns
+        const glm::mat4 &getNormalMatrix(Handle handle) const { return normalMatrices[handle]; }
+
+        bool isDirty(Handle handle) const { return dirtyBits[handle / 64] & (1ull << (handle % 64)); }
+        uint32_t getCount() const { return count; }
+
+    private:
+        static constexpr uint32_t GROUP_SIZE = 4;
+
+        void markDirty(Handle handle) { dirtyBits[handle / 64] |= 1ull << (handle % 64); }
+        void grow();
+        // Recomputes the GROUP_SIZE entries starting at first
+        void updateGroup(uint32_t first);
+
+        // Sized to a multiple of 64 so whole groups and dirty words are always in bounds
+        std::vector<float> translationX, translationY, translationZ;
+        std::vector<float> rotationX, rotationY, rotationZ;
+        std::vector<float> scaleX, scaleY, scaleZ;
+        std::vector<glm::mat4> worldMatrices;
+        std::vector<glm::mat4> normalMatrices;
+        std::vector<uint64_t> dirtyBits;
+
+        std::vector<Handle> freeHandles;
+        uint32_t capacity = 0;
+        uint32_t used = 0;
+        uint32_t count = 0;
+    };
+}
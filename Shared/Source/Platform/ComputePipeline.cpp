@@ -0,0 +1,65 @@
+#include "ComputePipeline.hpp"
+
+#include "Pipeline.hpp"
+
+// std
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+namespace VoxelEngine
+{
+
+    ComputePipeline::ComputePipeline(
+        Device &device,
+        const std::string &computeShaderPath,
+        VkPipelineLayout pipelineLayout,
+        const std::vector<ShaderDefine> &shaderDefines)
+        : device{device}
+    {
+        assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+
+        auto code = Pipeline::loadSpirv(device, computeShaderPath, shaderDefines);
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size() * sizeof(uint32_t);
+        moduleInfo.pCode = code.data();
+
+        if (vkCreateShaderModule(device.device(), &moduleInfo, nullptr, &computeShaderModule) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shader module");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = computeShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineIndex = -1;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        if (vkCreateComputePipelines(device.device(), device.pipelineCache(), 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS)
+        {
+            vkDestroyShaderModule(device.device(), computeShaderModule, nullptr);
+            throw std::runtime_error("failed to create compute pipeline");
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        device.recordPipelineCreation(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    ComputePipeline::~ComputePipeline()
+    {
+        vkDestroyShaderModule(device.device(), computeShaderModule, nullptr);
+        vkDestroyPipeline(device.device(), computePipeline, nullptr);
+    }
+
+    void ComputePipeline::bind(VkCommandBuffer commandBuffer)
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Device.hpp"
+
+#include <string>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // A compute shader and its pipeline, the layout is owned by the caller
+    class ComputePipeline
+    {
+        public:
+        ComputePipeline(
+            Device& device,
+            const std::string& computeShaderPath,
+            VkPipelineLayout pipelineLayout,
+            const std::vector<ShaderDefine>& shaderDefines = {});
+        ~ComputePipeline();
+
+        ComputePipeline(const ComputePipeline&) = delete;
+        ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+
+        private:
+        Device& device;
+        VkPipeline computePipeline;
+        VkShaderModule computeShaderModule;
+    };
+}
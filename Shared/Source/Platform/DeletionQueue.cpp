@@ -0,0 +1,70 @@
+#include "DeletionQueue.hpp"
+
+// std
+#include <vector>
+
+namespace VoxelEngine
+{
+    DeletionQueue::~DeletionQueue()
+    {
+        flush();
+    }
+
+    void DeletionQueue::push(std::function<void()> destroy)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (currentFrame != 0)
+            {
+                entries.push_back({currentFrame, std::move(destroy)});
+                return;
+            }
+        }
+        destroy();
+    }
+
+    void DeletionQueue::setCurrentFrame(Value value)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        currentFrame = value;
+    }
+
+    void DeletionQueue::collect(Value completedValue)
+    {
+        // Callbacks run without the lock, they may free memory or push more
+        std::vector<std::function<void()>> ready;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            while (!entries.empty() && entries.front().value <= completedValue)
+            {
+                ready.push_back(std::move(entries.front().destroy));
+                entries.pop_front();
+            }
+        }
+
+        for (auto &destroy : ready)
+        {
+            destroy();
+        }
+    }
+
+    void DeletionQueue::flush()
+    {
+        std::deque<Entry> ready;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            ready.swap(entries);
+        }
+
+        for (auto &entry : ready)
+        {
+            entry.destroy();
+        }
+    }
+
+    size_t DeletionQueue::size() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return entries.size();
+    }
+}
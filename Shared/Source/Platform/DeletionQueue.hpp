@@ -0,0 +1,54 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace VoxelEngine
+{
+    // Vulkan objects whose destruction waits for the frames that may still use them.
+    //
+    // The Renderer tells the queue which frame it is recording, as a FrameTimeline value, and
+    // collects every frame once its earlier submissions are done. Anything pushed meanwhile is
+    // destroyed once the frame being recorded at that point has finished on the GPU. While no
+    // renderer drives it, for instance before the first frame or after shutdown, push() destroys
+    // right away, like the destructors did before.
+    //
+    // push() may be called from any thread, collect() and flush() run the callbacks on the caller.
+    class DeletionQueue
+    {
+    public:
+        using Value = uint64_t;
+
+        DeletionQueue() = default;
+        ~DeletionQueue();
+
+        DeletionQueue(const DeletionQueue &) = delete;
+        DeletionQueue &operator=(const DeletionQueue &) = delete;
+
+        void push(std::function<void()> destroy);
+
+        // Value the next frame submission will signal, 0 stops deferring
+        void setCurrentFrame(Value value);
+        // Destroys everything pushed while a frame up to completedValue was being recorded
+        void collect(Value completedValue);
+        // Destroys everything, the GPU must be done with all of it
+        void flush();
+
+        size_t size() const;
+
+    private:
+        struct Entry
+        {
+            Value value;
+            std::function<void()> destroy;
+        };
+
+        mutable std::mutex mutex;
+        // Pushed in frame order, so they retire from the front
+        std::deque<Entry> entries;
+        Value currentFrame = 0;
+    };
+}
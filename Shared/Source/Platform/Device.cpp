@@ -2,6 +2,8 @@
 
 // std headers
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -63,10 +65,17 @@ namespace VoxelEngine
     pickPhysicalDevice();
     createLogicalDevice();
     createCommandPool();
+    createPipelineCache();
+    allocator_ = std::make_unique<MemoryAllocator>(physicalDevice, device_);
+    shaderManager_ = std::make_unique<ShaderManager>();
   }
 
   Device::~Device()
   {
+    deletionQueue_.flush();
+    savePipelineCache();
+    vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
+    allocator_.reset();
     vkDestroyCommandPool(device_, commandPool, nullptr);
     vkDestroyDevice(device_, nullptr);
 
@@ -99,6 +108,12 @@ namespace VoxelEngine
     createInfo.pApplicationInfo = &appInfo;
 
     auto extensions = getRequiredExtensions();
+    // Needed to query the timeline semaphore feature on a 1.0 instance
+    if (isInstanceExtensionSupported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+    {
+      extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+      physicalDeviceProperties2Enabled_ = true;
+    }
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -176,6 +191,10 @@ namespace VoxelEngine
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+    if (indices.transferFamilyHasValue)
+    {
+      uniqueQueueFamilies.insert(indices.transferFamily);
+    }
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -188,8 +207,15 @@ namespace VoxelEngine
       queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+    // Indirect terrain drawing uses firstInstance as the draw index and wants one call for all draws
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    enabledFeatures_ = deviceFeatures;
 
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -197,9 +223,28 @@ namespace VoxelEngine
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+    // Culled terrain draws pass their count in a buffer when the driver can read it from there
+    std::vector<const char *> enabledExtensions = deviceExtensions;
+    const bool drawIndirectCountSupported = isDeviceExtensionSupported(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    if (drawIndirectCountSupported)
+    {
+      enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+
+    // Frame pacing waits on a single timeline semaphore when the driver has them
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    const bool timelineSemaphoreSupported = isTimelineSemaphoreSupported(physicalDevice);
+    if (timelineSemaphoreSupported)
+    {
+      enabledExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+      timelineFeatures.timelineSemaphore = VK_TRUE;
+      createInfo.pNext = &timelineFeatures;
+    }
+
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     // might not really be necessary anymore because device specific validation layers
     // have been deprecated
@@ -218,8 +263,34 @@ namespace VoxelEngine
       throw std::runtime_error("failed to create logical device!");
     }
 
+    if (drawIndirectCountSupported)
+    {
+      cmdDrawIndexedIndirectCount_ = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+          vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCountKHR"));
+    }
+
+    if (timelineSemaphoreSupported)
+    {
+      waitSemaphores_ = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(
+          vkGetDeviceProcAddr(device_, "vkWaitSemaphoresKHR"));
+      getSemaphoreCounterValue_ = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+          vkGetDeviceProcAddr(device_, "vkGetSemaphoreCounterValueKHR"));
+    }
+
     vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
     vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+    graphicsQueueFamily_ = indices.graphicsFamily;
+    if (indices.transferFamilyHasValue)
+    {
+      transferQueueFamily_ = indices.transferFamily;
+      vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+    }
+    else
+    {
+      transferQueueFamily_ = indices.graphicsFamily;
+      transferQueue_ = graphicsQueue_;
+    }
   }
 
   void Device::createCommandPool()
@@ -238,6 +309,93 @@ namespace VoxelEngine
     }
   }
 
+  bool Device::isPipelineCacheCompatible(const std::vector<char> &data)
+  {
+    // Drivers should reject foreign data themselves, but not all of them do
+    VkPipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(header))
+    {
+      return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    return header.headerSize >= sizeof(header) &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == properties.vendorID &&
+           header.deviceID == properties.deviceID &&
+           std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+  }
+
+  void Device::createPipelineCache()
+  {
+    std::vector<char> data;
+    std::ifstream file{PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary};
+    if (file.is_open())
+    {
+      data.resize(static_cast<size_t>(file.tellg()));
+      file.seekg(0);
+      file.read(data.data(), static_cast<std::streamsize>(data.size()));
+      if (!file || !isPipelineCacheCompatible(data))
+      {
+        std::cout << "pipeline cache: ignoring " << PIPELINE_CACHE_PATH << ", it is from another device or driver" << std::endl;
+        data.clear();
+      }
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS)
+    {
+      // Start empty rather than fail because of a bad file
+      cacheInfo.initialDataSize = 0;
+      cacheInfo.pInitialData = nullptr;
+      data.clear();
+      if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS)
+      {
+        throw std::runtime_error("failed to create pipeline cache!");
+      }
+    }
+
+    pipelineCacheStats_.loadedFromDisk = !data.empty();
+    pipelineCacheStats_.loadedBytes = data.size();
+  }
+
+  void Device::savePipelineCache()
+  {
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0)
+    {
+      return;
+    }
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS)
+    {
+      return;
+    }
+
+    // Write a temporary file and rename it, so a crash mid-write never leaves a truncated cache
+    const std::string tempPath = std::string{PIPELINE_CACHE_PATH} + ".tmp";
+    {
+      std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+      file.write(data.data(), static_cast<std::streamsize>(size));
+      if (!file)
+      {
+        std::cerr << "pipeline cache: failed to write " << tempPath << std::endl;
+        return;
+      }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, PIPELINE_CACHE_PATH, error);
+    if (error)
+    {
+      std::cerr << "pipeline cache: failed to replace " << PIPELINE_CACHE_PATH << ": " << error.message() << std::endl;
+    }
+  }
+
   void Device::createSurface() { window.createWindowSurface(instance, &surface_); }
 
   bool Device::isDeviceSuitable(VkPhysicalDevice device)
@@ -381,6 +539,69 @@ namespace VoxelEngine
     return requiredExtensions.empty();
   }
 
+  bool Device::isInstanceExtensionSupported(const char *extensionName)
+  {
+    uint32_t extensionCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+    for (const auto &extension : extensions)
+    {
+      if (strcmp(extension.extensionName, extensionName) == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool Device::isTimelineSemaphoreSupported(VkPhysicalDevice device)
+  {
+    if (!physicalDeviceProperties2Enabled_ || !isDeviceExtensionSupported(device, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+    {
+      return false;
+    }
+
+    auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+    if (getFeatures2 == nullptr)
+    {
+      return false;
+    }
+
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    VkPhysicalDeviceFeatures2KHR features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &timelineFeatures;
+    getFeatures2(device, &features);
+
+    return timelineFeatures.timelineSemaphore == VK_TRUE;
+  }
+
+  bool Device::isDeviceExtensionSupported(VkPhysicalDevice device, const char *extensionName)
+  {
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(
+        device,
+        nullptr,
+        &extensionCount,
+        availableExtensions.data());
+
+    for (const auto &extension : availableExtensions)
+    {
+      if (strcmp(extension.extensionName, extensionName) == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
   QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device)
   {
     QueueFamilyIndices indices;
@@ -394,21 +615,30 @@ namespace VoxelEngine
     int i = 0;
     for (const auto &queueFamily : queueFamilies)
     {
-      if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+      if (!indices.isComplete())
       {
-        indices.graphicsFamily = i;
-        indices.graphicsFamilyHasValue = true;
-      }
-      VkBool32 presentSupport = false;
-      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-      if (queueFamily.queueCount > 0 && presentSupport)
-      {
-        indices.presentFamily = i;
-        indices.presentFamilyHasValue = true;
+        if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        {
+          indices.graphicsFamily = i;
+          indices.graphicsFamilyHasValue = true;
+        }
+        VkBool32 presentSupport = false;
+        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+        if (queueFamily.queueCount > 0 && presentSupport)
+        {
+          indices.presentFamily = i;
+          indices.presentFamilyHasValue = true;
+        }
       }
-      if (indices.isComplete())
+
+      // Prefer a transfer-only family (the DMA engine) over an async compute one
+      const bool transferOnly = (queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0;
+      if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT &&
+          !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+          (!indices.transferFamilyHasValue || transferOnly))
       {
-        break;
+        indices.transferFamily = i;
+        indices.transferFamilyHasValue = true;
       }
 
       i++;
@@ -487,7 +717,7 @@ namespace VoxelEngine
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory)
+      MemoryAllocation &bufferMemory)
   {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -495,6 +725,15 @@ namespace VoxelEngine
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // Buffers filled from the transfer queue are shared so no queue family ownership transfer is needed
+    const uint32_t queueFamilies[] = {graphicsQueueFamily_, transferQueueFamily_};
+    if ((usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && hasDedicatedTransferQueue())
+    {
+      bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+      bufferInfo.queueFamilyIndexCount = 2;
+      bufferInfo.pQueueFamilyIndices = queueFamilies;
+    }
+
     if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
     {
       throw std::runtime_error("failed to create vertex buffer!");
@@ -503,17 +742,9 @@ namespace VoxelEngine
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-    {
-      throw std::runtime_error("failed to allocate vertex buffer memory!");
-    }
+    bufferMemory = allocator_->allocate(memRequirements, properties, true);
 
-    vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+    vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset);
   }
 
   VkCommandBuffer Device::beginSingleTimeCommands()
@@ -544,9 +775,19 @@ namespace VoxelEngine
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
 
-    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue_);
+    // Wait for this submission only instead of draining the whole graphics queue
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkFence fence;
+    if (vkCreateFence(device_, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+    {
+      throw std::runtime_error("failed to create single time command fence!");
+    }
 
+    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+    vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
+
+    vkDestroyFence(device_, fence, nullptr);
     vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
   }
 
@@ -595,9 +836,19 @@ namespace VoxelEngine
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory)
+      MemoryAllocation &imageMemory)
   {
-    if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS)
+    // Like buffers, images filled from the transfer queue are shared between both families
+    VkImageCreateInfo info = imageInfo;
+    const uint32_t queueFamilies[] = {graphicsQueueFamily_, transferQueueFamily_};
+    if ((info.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) && hasDedicatedTransferQueue())
+    {
+      info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+      info.queueFamilyIndexCount = 2;
+      info.pQueueFamilyIndices = queueFamilies;
+    }
+
+    if (vkCreateImage(device_, &info, nullptr, &image) != VK_SUCCESS)
     {
       throw std::runtime_error("failed to create image!");
     }
@@ -605,17 +856,9 @@ namespace VoxelEngine
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-    {
-      throw std::runtime_error("failed to allocate image memory!");
-    }
+    imageMemory = allocator_->allocate(memRequirements, properties, info.tiling == VK_IMAGE_TILING_LINEAR);
 
-    if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS)
+    if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS)
     {
       throw std::runtime_error("failed to bind image memory!");
     }
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "Window.hpp"
+#include "MemoryAllocator.hpp"
+#include "ShaderManager.hpp"
+#include "DeletionQueue.hpp"
 
 // std lib headers
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -20,14 +25,29 @@ namespace VoxelEngine
   {
     uint32_t graphicsFamily;
     uint32_t presentFamily;
+    // Only set for a family without graphics support, copies there run beside rendering
+    uint32_t transferFamily;
     bool graphicsFamilyHasValue = false;
     bool presentFamilyHasValue = false;
+    bool transferFamilyHasValue = false;
     bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
   };
 
+  // Time spent in vkCreate*Pipelines, to compare a cold pipeline cache with a warm one
+  struct PipelineCacheStats
+  {
+    bool loadedFromDisk = false;
+    size_t loadedBytes = 0;
+    uint32_t pipelineCount = 0;
+    double creationMicroseconds = 0.0;
+  };
+
   class Device
   {
   public:
+    // Relative to the working directory, like the shader and model paths
+    static constexpr const char *PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
 #ifdef NDEBUG
     const bool enableValidationLayers = false;
 #else
@@ -48,6 +68,10 @@ namespace VoxelEngine
     VkSurfaceKHR surface() { return surface_; }
     VkQueue graphicsQueue() { return graphicsQueue_; }
     VkQueue presentQueue() { return presentQueue_; }
+    // Falls back to the graphics queue when there is no dedicated transfer family
+    VkQueue transferQueue() { return transferQueue_; }
+    uint32_t transferQueueFamily() { return transferQueueFamily_; }
+    bool hasDedicatedTransferQueue() { return transferQueue_ != graphicsQueue_; }
 
     SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -56,6 +80,29 @@ namespace VoxelEngine
         const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
     VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
+    const VkPhysicalDeviceFeatures &enabledFeatures() { return enabledFeatures_; }
+    // nullptr unless VK_KHR_draw_indirect_count is available
+    PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount() { return cmdDrawIndexedIndirectCount_; }
+    // nullptr unless VK_KHR_timeline_semaphore is enabled, frame pacing falls back to fences then
+    PFN_vkWaitSemaphoresKHR waitSemaphores() { return waitSemaphores_; }
+    PFN_vkGetSemaphoreCounterValueKHR getSemaphoreCounterValue() { return getSemaphoreCounterValue_; }
+    bool hasTimelineSemaphores() { return waitSemaphores_ != nullptr; }
+
+    // Shared by every pipeline, loaded from PIPELINE_CACHE_PATH and written back on destruction
+    VkPipelineCache pipelineCache() { return pipelineCache_; }
+    void savePipelineCache();
+    // Pipelines can be built on worker threads, so the counters take a lock
+    void recordPipelineCreation(double microseconds)
+    {
+      std::lock_guard<std::mutex> lock{pipelineCacheStatsMutex_};
+      pipelineCacheStats_.pipelineCount++;
+      pipelineCacheStats_.creationMicroseconds += microseconds;
+    }
+    PipelineCacheStats getPipelineCacheStats()
+    {
+      std::lock_guard<std::mutex> lock{pipelineCacheStatsMutex_};
+      return pipelineCacheStats_;
+    }
 
     // Buffer Helper Functions
     void createBuffer(
@@ -63,7 +110,7 @@ namespace VoxelEngine
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer &buffer,
-        VkDeviceMemory &bufferMemory);
+        MemoryAllocation &bufferMemory);
     VkCommandBuffer beginSingleTimeCommands();
     void endSingleTimeCommands(VkCommandBuffer commandBuffer);
     void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -74,7 +121,13 @@ namespace VoxelEngine
         const VkImageCreateInfo &imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage &image,
-        VkDeviceMemory &imageMemory);
+        MemoryAllocation &imageMemory);
+    // Returns memory from createBuffer or createImageWithInfo, destroy the resource first
+    void freeMemory(MemoryAllocation &memory) { allocator_->free(memory); }
+    MemoryAllocator &allocator() { return *allocator_; }
+    // Buffers and textures hand their handles over here instead of destroying them in use
+    DeletionQueue &deletionQueue() { return deletionQueue_; }
+    ShaderManager &shaderManager() { return *shaderManager_; }
 
     VkPhysicalDeviceProperties properties;
 
@@ -85,6 +138,7 @@ namespace VoxelEngine
     void pickPhysicalDevice();
     void createLogicalDevice();
     void createCommandPool();
+    void createPipelineCache();
 
     // helper functions
     bool isDeviceSuitable(VkPhysicalDevice device);
@@ -94,18 +148,36 @@ namespace VoxelEngine
     void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
     void hasGflwRequiredInstanceExtensions();
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+    bool isDeviceExtensionSupported(VkPhysicalDevice device, const char *extensionName);
+    bool isInstanceExtensionSupported(const char *extensionName);
+    bool isTimelineSemaphoreSupported(VkPhysicalDevice device);
     SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+    bool isPipelineCacheCompatible(const std::vector<char> &data);
 
     VkInstance instance;
     VkDebugUtilsMessengerEXT debugMessenger;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     Window &window;
     VkCommandPool commandPool;
+    std::unique_ptr<MemoryAllocator> allocator_;
+    std::unique_ptr<ShaderManager> shaderManager_;
+    DeletionQueue deletionQueue_;
 
     VkDevice device_;
     VkSurfaceKHR surface_;
+    VkPhysicalDeviceFeatures enabledFeatures_{};
+    PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount_ = nullptr;
+    bool physicalDeviceProperties2Enabled_ = false;
+    PFN_vkWaitSemaphoresKHR waitSemaphores_ = nullptr;
+    PFN_vkGetSemaphoreCounterValueKHR getSemaphoreCounterValue_ = nullptr;
+    VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+    PipelineCacheStats pipelineCacheStats_{};
+    std::mutex pipelineCacheStatsMutex_;
     VkQueue graphicsQueue_;
     VkQueue presentQueue_;
+    VkQueue transferQueue_;
+    uint32_t graphicsQueueFamily_;
+    uint32_t transferQueueFamily_;
 
     const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
     const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
@@ -0,0 +1,179 @@
+#include "FrameTimeline.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+namespace VoxelEngine
+{
+    FrameTimeline::FrameTimeline(Device &device, uint32_t framesInFlight) : device{device}
+    {
+        assert(framesInFlight > 0 && "Frame timeline needs at least one frame in flight");
+
+        if (device.hasTimelineSemaphores())
+        {
+            VkSemaphoreTypeCreateInfoKHR typeInfo{};
+            typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+            typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+            typeInfo.initialValue = 0;
+
+            VkSemaphoreCreateInfo semaphoreInfo{};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            semaphoreInfo.pNext = &typeInfo;
+
+            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &timelineSemaphore) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create frame timeline semaphore!");
+            }
+            return;
+        }
+
+        fences.resize(framesInFlight);
+        fenceValues.resize(framesInFlight, 0);
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        for (auto &fence : fences)
+        {
+            if (vkCreateFence(device.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create frame fence!");
+            }
+        }
+    }
+
+    FrameTimeline::~FrameTimeline()
+    {
+        wait(submittedValue);
+
+        if (timelineSemaphore != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(device.device(), timelineSemaphore, nullptr);
+        }
+        for (auto fence : fences)
+        {
+            vkDestroyFence(device.device(), fence, nullptr);
+        }
+    }
+
+    FrameTimeline::Value FrameTimeline::submit(const VkSubmitInfo &submitInfo)
+    {
+        const Value value = submittedValue + 1;
+        VkSubmitInfo info = submitInfo;
+
+        if (timelineSemaphore != VK_NULL_HANDLE)
+        {
+            // Binary semaphores ignore their value, but every signal needs a slot in the array
+            std::vector<VkSemaphore> signalSemaphores(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+            signalSemaphores.push_back(timelineSemaphore);
+            std::vector<uint64_t> signalValues(signalSemaphores.size(), 0);
+            signalValues.back() = value;
+
+            VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+            timelineInfo.pNext = submitInfo.pNext;
+            timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+            timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+            info.pNext = &timelineInfo;
+            info.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+            info.pSignalSemaphores = signalSemaphores.data();
+
+            if (vkQueueSubmit(device.graphicsQueue(), 1, &info, VK_NULL_HANDLE) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to submit draw command buffer!");
+            }
+        }
+        else
+        {
+            const size_t index = value % fences.size();
+            // Normally long finished, the caller already waited for the frame that used this slot
+            wait(fenceValues[index]);
+            vkResetFences(device.device(), 1, &fences[index]);
+
+            if (vkQueueSubmit(device.graphicsQueue(), 1, &info, fences[index]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to submit draw command buffer!");
+            }
+            fenceValues[index] = value;
+        }
+
+        submittedValue = value;
+        return value;
+    }
+
+    void FrameTimeline::wait(Value value)
+    {
+        if (value <= completedValue)
+        {
+            return;
+        }
+        assert(value <= submittedValue && "Cannot wait for a frame that was never submitted");
+
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        if (timelineSemaphore != VK_NULL_HANDLE)
+        {
+            VkSemaphoreWaitInfoKHR waitInfo{};
+            waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &timelineSemaphore;
+            waitInfo.pValues = &value;
+
+            if (device.waitSemaphores()(device.device(), &waitInfo, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to wait for frame timeline semaphore!");
+            }
+        }
+        else
+        {
+            // A newer value in the slot means this one finished before the fence was reused
+            const size_t index = value % fences.size();
+            if (fenceValues[index] == value)
+            {
+                vkWaitForFences(device.device(), 1, &fences[index], VK_TRUE, std::numeric_limits<uint64_t>::max());
+            }
+        }
+
+        // The queue finishes submissions in order
+        completedValue = value;
+
+        const auto end = std::chrono::high_resolution_clock::now();
+        waitMicroseconds += std::chrono::duration<double, std::micro>(end - start).count();
+    }
+
+    bool FrameTimeline::isComplete(Value value)
+    {
+        return value <= completedValue || value <= getCompletedValue();
+    }
+
+    FrameTimeline::Value FrameTimeline::getCompletedValue()
+    {
+        completedValue = std::max(completedValue, queryCompletedValue());
+        return completedValue;
+    }
+
+    FrameTimeline::Value FrameTimeline::queryCompletedValue()
+    {
+        if (timelineSemaphore != VK_NULL_HANDLE)
+        {
+            uint64_t value = 0;
+            device.getSemaphoreCounterValue()(device.device(), timelineSemaphore, &value);
+            return value;
+        }
+
+        Value value = 0;
+        for (size_t i = 0; i < fences.size(); i++)
+        {
+            if (fenceValues[i] > value && vkGetFenceStatus(device.device(), fences[i]) == VK_SUCCESS)
+            {
+                value = fenceValues[i];
+            }
+        }
+        return value;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Device.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // GPU progress of the frames submitted to the graphics queue.
+    //
+    // Every submit() signals the next value of one timeline semaphore, and waiting for a frame is
+    // waiting for the semaphore to reach that value. Without VK_KHR_timeline_semaphore the values
+    // map onto a ring of fences instead, one per frame in flight, which is enough as long as the
+    // caller never waits for a value older than the ring.
+    //
+    // Time spent blocked in wait() is accumulated so the cost of fewer frames in flight is visible.
+    class FrameTimeline
+    {
+    public:
+        using Value = uint64_t;
+
+        FrameTimeline(Device &device, uint32_t framesInFlight);
+        ~FrameTimeline();
+
+        FrameTimeline(const FrameTimeline &) = delete;
+        FrameTimeline &operator=(const FrameTimeline &) = delete;
+
+        // Submits to the graphics queue, signalling the next value besides submitInfo's own semaphores
+        Value submit(const VkSubmitInfo &submitInfo);
+        // Blocks until the submission that returned value has finished, 0 never blocks
+        void wait(Value value);
+        bool isComplete(Value value);
+        // Polls the GPU, every submission up to the returned value has finished
+        Value getCompletedValue();
+
+        Value getSubmittedValue() const { return submittedValue; }
+        bool usesTimelineSemaphore() const { return timelineSemaphore != VK_NULL_HANDLE; }
+
+        double getWaitMicroseconds() const { return waitMicroseconds; }
+        void resetWaitMicroseconds() { waitMicroseconds = 0.0; }
+
+    private:
+        Value queryCompletedValue();
+
+        Device &device;
+        VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+        // Fallback ring, fence i belongs to the values congruent to i
+        std::vector<VkFence> fences;
+        std::vector<Value> fenceValues;
+
+        Value submittedValue = 0;
+        Value completedValue = 0;
+        double waitMicroseconds = 0.0;
+    };
+}
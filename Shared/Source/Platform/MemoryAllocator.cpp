@@ -0,0 +1,231 @@
+#include "MemoryAllocator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace VoxelEngine
+{
+    struct MemoryBlock
+    {
+        MemoryBlock(VkDeviceMemory memory, VkDeviceSize size, void *mapped) : memory{memory}, mapped{mapped}, heap{size} {}
+
+        VkDeviceMemory memory;
+        void *mapped;
+        TlsfHeap heap;
+    };
+
+    MemoryAllocator::MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device) : device{device}
+    {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+        for (auto &typePools : pools)
+        {
+            for (auto &pool : typePools)
+            {
+                for (auto &block : pool.blocks)
+                {
+                    assert(block->heap.isEmpty() && "Memory block still has live allocations");
+                    vkFreeMemory(device, block->memory, nullptr);
+                }
+            }
+        }
+    }
+
+    uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            if ((typeFilter & (1u << i)) &&
+                (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryType) const
+    {
+        // Small heaps, such as the 256 MiB host-visible window into VRAM, get smaller blocks
+        const uint32_t heapIndex = memoryProperties.memoryTypes[memoryType].heapIndex;
+        return std::min(DEFAULT_BLOCK_SIZE, memoryProperties.memoryHeaps[heapIndex].size / 8);
+    }
+
+    VkDeviceMemory MemoryAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void **mapped)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryType;
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate device memory!");
+        }
+
+        *mapped = nullptr;
+        if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+            {
+                vkFreeMemory(device, memory, nullptr);
+                throw std::runtime_error("failed to map device memory!");
+            }
+        }
+        return memory;
+    }
+
+    MemoryAllocation MemoryAllocator::allocateDedicated(VkDeviceSize size, uint32_t memoryType)
+    {
+        MemoryAllocation allocation{};
+        allocation.memory = allocateDeviceMemory(size, memoryType, &allocation.mapped);
+        allocation.size = size;
+        allocation.memoryType = memoryType;
+
+        const uint32_t heapIndex = memoryProperties.memoryTypes[memoryType].heapIndex;
+        dedicatedBytes[heapIndex] += size;
+        dedicatedCounts[heapIndex]++;
+        return allocation;
+    }
+
+    MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool linear)
+    {
+        const uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+        const VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[memoryType].propertyFlags;
+
+        // Non-coherent ranges are flushed per allocation, keep them on their own atoms
+        VkDeviceSize size = requirements.size;
+        VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+        if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+        {
+            alignment = std::max(alignment, nonCoherentAtomSize);
+            size = (size + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        const VkDeviceSize blockSize = getBlockSize(memoryType);
+        if (size > blockSize / 2)
+        {
+            return allocateDedicated(size, memoryType);
+        }
+
+        Pool &pool = pools[memoryType][linear ? 0 : 1];
+        MemoryAllocation allocation{};
+        allocation.size = size;
+        allocation.memoryType = memoryType;
+
+        for (auto &block : pool.blocks)
+        {
+            allocation.node = block->heap.allocate(size, alignment, allocation.offset);
+            if (allocation.node != TlsfHeap::INVALID_NODE)
+            {
+                allocation.block = block.get();
+                break;
+            }
+        }
+
+        if (!allocation.block)
+        {
+            void *mapped;
+            VkDeviceMemory memory = allocateDeviceMemory(blockSize, memoryType, &mapped);
+            pool.blocks.push_back(std::make_unique<MemoryBlock>(memory, blockSize, mapped));
+            allocation.block = pool.blocks.back().get();
+            allocation.node = allocation.block->heap.allocate(size, alignment, allocation.offset);
+            assert(allocation.node != TlsfHeap::INVALID_NODE && "Fresh memory block cannot fit the allocation");
+        }
+
+        allocation.memory = allocation.block->memory;
+        if (allocation.block->mapped)
+        {
+            allocation.mapped = static_cast<char *>(allocation.block->mapped) + allocation.offset;
+        }
+        return allocation;
+    }
+
+    void MemoryAllocator::free(MemoryAllocation &allocation)
+    {
+        if (allocation.memory == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (!allocation.block)
+        {
+            const uint32_t heapIndex = memoryProperties.memoryTypes[allocation.memoryType].heapIndex;
+            dedicatedBytes[heapIndex] -= allocation.size;
+            dedicatedCounts[heapIndex]--;
+            vkFreeMemory(device, allocation.memory, nullptr);
+            allocation = MemoryAllocation{};
+            return;
+        }
+
+        MemoryBlock *block = allocation.block;
+        block->heap.free(allocation.node);
+
+        // Give empty blocks back to the driver, but keep one per pool so churn does not thrash
+        if (block->heap.isEmpty())
+        {
+            for (auto &pool : pools[allocation.memoryType])
+            {
+                auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(), [&](const auto &candidate)
+                                       { return candidate.get() == block; });
+                if (it == pool.blocks.end())
+                {
+                    continue;
+                }
+                if (pool.blocks.size() > 1)
+                {
+                    vkFreeMemory(device, block->memory, nullptr);
+                    pool.blocks.erase(it);
+                }
+                break;
+            }
+        }
+        allocation = MemoryAllocation{};
+    }
+
+    std::vector<MemoryAllocator::HeapStats> MemoryAllocator::getHeapStats() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        std::vector<HeapStats> stats(memoryProperties.memoryHeapCount);
+        for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++)
+        {
+            HeapStats &heap = stats[memoryProperties.memoryTypes[type].heapIndex];
+            for (const auto &pool : pools[type])
+            {
+                for (const auto &block : pool.blocks)
+                {
+                    heap.reservedBytes += block->heap.getSize();
+                    heap.usedBytes += block->heap.getUsedBytes();
+                    heap.largestFreeRange = std::max(heap.largestFreeRange, block->heap.getLargestFreeRange());
+                    heap.blockCount++;
+                    heap.allocationCount += block->heap.getAllocationCount();
+                }
+            }
+        }
+
+        for (uint32_t heapIndex = 0; heapIndex < memoryProperties.memoryHeapCount; heapIndex++)
+        {
+            stats[heapIndex].reservedBytes += dedicatedBytes[heapIndex];
+            stats[heapIndex].usedBytes += dedicatedBytes[heapIndex];
+            stats[heapIndex].blockCount += dedicatedCounts[heapIndex];
+            stats[heapIndex].allocationCount += dedicatedCounts[heapIndex];
+        }
+        return stats;
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Utils/TlsfHeap.hpp"
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace VoxelEngine
+{
+    struct MemoryBlock;
+
+    // A range of device memory handed out by MemoryAllocator. Bind resources at memory + offset.
+    struct MemoryAllocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        // Already offset into the block, only set for host-visible memory types
+        void *mapped = nullptr;
+        uint32_t memoryType = 0;
+
+        // nullptr for dedicated allocations that own their VkDeviceMemory
+        MemoryBlock *block = nullptr;
+        uint32_t node = TlsfHeap::INVALID_NODE;
+    };
+
+    // Sub-allocates buffers and images from large VkDeviceMemory blocks.
+    //
+    // Every memory type has one pool for linear resources (buffers) and one for optimal-tiling
+    // images. Keeping them apart means bufferImageGranularity never has to be padded for. Ranges
+    // inside a block come from a TlsfHeap. Host-visible blocks stay mapped for their whole life,
+    // because the same VkDeviceMemory cannot be mapped twice. Requests larger than half a block
+    // get a dedicated allocation.
+    class MemoryAllocator
+    {
+    public:
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+        struct HeapStats
+        {
+            VkDeviceSize reservedBytes = 0;
+            VkDeviceSize usedBytes = 0;
+            VkDeviceSize largestFreeRange = 0;
+            uint32_t blockCount = 0;
+            uint32_t allocationCount = 0;
+
+            // 0 when all free space is one range, towards 1 as it splinters
+            float getFragmentation() const
+            {
+                const VkDeviceSize freeBytes = reservedBytes - usedBytes;
+                return freeBytes > 0 ? 1.f - static_cast<float>(largestFreeRange) / static_cast<float>(freeBytes) : 0.f;
+            }
+        };
+
+        MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+        ~MemoryAllocator();
+
+        MemoryAllocator(const MemoryAllocator &) = delete;
+        MemoryAllocator &operator=(const MemoryAllocator &) = delete;
+
+        // linear is true for buffers and linear-tiling images
+        MemoryAllocation allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, bool linear);
+        void free(MemoryAllocation &allocation);
+
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+        // Indexed by memory heap
+        std::vector<HeapStats> getHeapStats() const;
+
+    private:
+        struct Pool
+        {
+            std::vector<std::unique_ptr<MemoryBlock>> blocks;
+        };
+
+        VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void **mapped);
+        MemoryAllocation allocateDedicated(VkDeviceSize size, uint32_t memoryType);
+        VkDeviceSize getBlockSize(uint32_t memoryType) const;
+
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        VkDeviceSize nonCoherentAtomSize;
+
+        std::array<std::array<Pool, 2>, VK_MAX_MEMORY_TYPES> pools;
+        // Dedicated allocations only show up in the stats
+        std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> dedicatedBytes{};
+        std::array<uint32_t, VK_MAX_MEMORY_HEAPS> dedicatedCounts{};
+
+        mutable std::mutex mutex;
+    };
+}
@@ -0,0 +1,90 @@
+#include "MeshArena.hpp"
+
+// std
+#include <cassert>
+
+namespace VoxelEngine
+{
+    MeshArena::MeshArena(Device &device, Model::VertexFormat vertexFormat, uint32_t vertexCapacity, uint32_t indexCapacity)
+        : vertexFormat{vertexFormat},
+          vertexSize{static_cast<uint32_t>(vertexFormat == Model::VertexFormat::Packed ? sizeof(Model::PackedVertex) : sizeof(Model::Vertex))},
+          vertexHeap{vertexCapacity},
+          indexHeap{indexCapacity}
+    {
+        vertexBuffer = std::make_unique<Buffer>(
+            device,
+            vertexSize,
+            vertexCapacity,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        indexBuffer = std::make_unique<Buffer>(
+            device,
+            sizeof(uint32_t),
+            indexCapacity,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    bool MeshArena::allocate(const Model::Builder &builder, UploadManager &uploadManager, Mesh &mesh)
+    {
+        assert(builder.vertexFormat == vertexFormat && "Mesh vertex format does not match the arena");
+        assert(!builder.indices.empty() && "Arena meshes must be indexed");
+
+        const bool packed = vertexFormat == Model::VertexFormat::Packed;
+        const void *vertices = packed ? static_cast<const void *>(builder.packedVertices.data()) : builder.vertices.data();
+        const uint64_t vertexCount = packed ? builder.packedVertices.size() : builder.vertices.size();
+        const uint64_t indexCount = builder.indices.size();
+
+        uint64_t vertexOffset;
+        const uint32_t vertexNode = vertexHeap.allocate(vertexCount, 1, vertexOffset);
+        if (vertexNode == TlsfHeap::INVALID_NODE)
+        {
+            return false;
+        }
+
+        uint64_t firstIndex;
+        const uint32_t indexNode = indexHeap.allocate(indexCount, 1, firstIndex);
+        if (indexNode == TlsfHeap::INVALID_NODE)
+        {
+            vertexHeap.free(vertexNode);
+            return false;
+        }
+
+        uploadManager.uploadBuffer(vertices, vertexCount * vertexSize, vertexBuffer->getBuffer(), vertexOffset * vertexSize);
+        mesh.uploadTicket = uploadManager.uploadBuffer(
+            builder.indices.data(), indexCount * sizeof(uint32_t), indexBuffer->getBuffer(), firstIndex * sizeof(uint32_t));
+
+        mesh.vertexNode = vertexNode;
+        mesh.indexNode = indexNode;
+        mesh.vertexOffset = static_cast<int32_t>(vertexOffset);
+        mesh.firstIndex = static_cast<uint32_t>(firstIndex);
+        mesh.indexCount = static_cast<uint32_t>(indexCount);
+        return true;
+    }
+
+    void MeshArena::free(Mesh &mesh)
+    {
+        if (!mesh.isValid())
+        {
+            return;
+        }
+
+        vertexHeap.free(mesh.vertexNode);
+        indexHeap.free(mesh.indexNode);
+        mesh = Mesh{};
+    }
+
+    void MeshArena::bind(VkCommandBuffer commandBuffer)
+    {
+        VkBuffer buffers[] = {vertexBuffer->getBuffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    void MeshArena::draw(VkCommandBuffer commandBuffer, const Mesh &mesh, uint32_t firstInstance)
+    {
+        vkCmdDrawIndexed(commandBuffer, mesh.indexCount, 1, mesh.firstIndex, mesh.vertexOffset, firstInstance);
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Model.hpp"
+#include "UploadManager.hpp"
+#include "Utils/TlsfHeap.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+
+namespace VoxelEngine
+{
+    // One device-local vertex buffer and one index buffer shared by many meshes of a single vertex
+    // format.
+    //
+    // Meshes are sub-allocated in whole vertices and indices, so a draw only needs its firstIndex
+    // and vertexOffset after a single bind() for the whole arena. Indices stay mesh-local. Freed
+    // ranges merge with their free neighbours right away, which keeps remeshing from splintering
+    // the arena.
+    class MeshArena
+    {
+    public:
+        struct Mesh
+        {
+            uint32_t vertexNode = TlsfHeap::INVALID_NODE;
+            uint32_t indexNode = TlsfHeap::INVALID_NODE;
+            int32_t vertexOffset = 0;
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            // Draw only once this upload has completed
+            UploadManager::Ticket uploadTicket = UploadManager::COMPLETED_TICKET;
+
+            bool isValid() const { return vertexNode != TlsfHeap::INVALID_NODE; }
+        };
+
+        MeshArena(Device &device, Model::VertexFormat vertexFormat, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+        MeshArena(const MeshArena &) = delete;
+        MeshArena &operator=(const MeshArena &) = delete;
+
+        // Returns false and leaves mesh untouched when either range does not fit
+        bool allocate(const Model::Builder &builder, UploadManager &uploadManager, Mesh &mesh);
+        // The GPU must be done with the mesh, both reading it for draws and writing its upload
+        void free(Mesh &mesh);
+
+        void bind(VkCommandBuffer commandBuffer);
+        static void draw(VkCommandBuffer commandBuffer, const Mesh &mesh, uint32_t firstInstance = 0);
+
+        Model::VertexFormat getVertexFormat() const { return vertexFormat; }
+        uint32_t getMeshCount() const { return vertexHeap.getAllocationCount(); }
+        uint64_t getUsedVertices() const { return vertexHeap.getUsedBytes(); }
+        uint64_t getUsedIndices() const { return indexHeap.getUsedBytes(); }
+        uint32_t getVertexCapacity() const { return static_cast<uint32_t>(vertexHeap.getSize()); }
+        uint32_t getIndexCapacity() const { return static_cast<uint32_t>(indexHeap.getSize()); }
+
+    private:
+        Model::VertexFormat vertexFormat;
+        uint32_t vertexSize;
+
+        std::unique_ptr<Buffer> vertexBuffer;
+        std::unique_ptr<Buffer> indexBuffer;
+        // Both heaps count elements, not bytes
+        TlsfHeap vertexHeap;
+        TlsfHeap indexHeap;
+    };
+}
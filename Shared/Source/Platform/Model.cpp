@@ -1,69 +1,351 @@
 #include "Model.hpp"
 
-#include "Utils/Utils.hpp"
+#include "Utils/MappedFile.hpp"
 
 // libs
 #define TINYOBJECTLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
 
 // std
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
-#include <unordered_map>
+#include <thread>
+#include <type_traits>
 
-namespace std
+namespace VoxelEngine
 {
-    template <>
-    struct hash<VoxelEngine::Model::Vertex>
+    namespace
     {
-        size_t operator()(VoxelEngine::Model::Vertex const &vertex) const
+        constexpr uint32_t MESH_CACHE_MAGIC = 0x4853454D; // "MESH"
+        constexpr uint32_t MESH_CACHE_VERSION = 1;
+
+        // Followed by the vertex blob and then the index blob, both 4 byte aligned
+        struct MeshCacheHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            // Identifies the source file the cache was built from
+            uint64_t sourceSize;
+            int64_t sourceWriteTime;
+            uint32_t vertexFormat;
+            uint32_t vertexSize;
+            uint32_t vertexCount;
+            uint32_t indexCount;
+            float boundsMin[3];
+            float boundsMax[3];
+        };
+        static_assert(sizeof(MeshCacheHeader) % 4 == 0, "Mesh blobs must stay 4 byte aligned");
+        static_assert(std::is_trivially_copyable_v<Model::Vertex>, "Vertices are copied as raw bytes");
+
+        bool getSourceStamp(const std::string &filepath, uint64_t &size, int64_t &writeTime)
         {
-            size_t seed = 0;
-            VoxelEngine::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-            return seed;
+            std::error_code error;
+            size = std::filesystem::file_size(filepath, error);
+            if (error)
+            {
+                return false;
+            }
+            writeTime = static_cast<int64_t>(std::filesystem::last_write_time(filepath, error).time_since_epoch().count());
+            return !error;
         }
-    };
-}
 
-namespace VoxelEngine
-{
+        // Open addressing map from an OBJ index triplet to the vertex it became, linear probing
+        class IndexTripletMap
+        {
+        public:
+            explicit IndexTripletMap(size_t expectedCount)
+            {
+                size_t capacity = 16;
+                while (capacity < expectedCount * 2)
+                {
+                    capacity *= 2;
+                }
+                slots.resize(capacity);
+            }
+
+            // Returns the vertex already stored for key, or stores and returns newVertex
+            uint32_t findOrInsert(const tinyobj::index_t &key, uint32_t newVertex)
+            {
+                if ((count + 1) * 2 > slots.size())
+                {
+                    grow();
+                }
+
+                const size_t mask = slots.size() - 1;
+                for (size_t i = hash(key) & mask;; i = (i + 1) & mask)
+                {
+                    Slot &slot = slots[i];
+                    if (slot.vertex == EMPTY)
+                    {
+                        slot.key = key;
+                        slot.vertex = newVertex;
+                        count++;
+                        return newVertex;
+                    }
+                    if (slot.key.vertex_index == key.vertex_index && slot.key.normal_index == key.normal_index &&
+                        slot.key.texcoord_index == key.texcoord_index)
+                    {
+                        return slot.vertex;
+                    }
+                }
+            }
+
+        private:
+            static constexpr uint32_t EMPTY = UINT32_MAX;
+
+            struct Slot
+            {
+                tinyobj::index_t key;
+                uint32_t vertex = EMPTY;
+            };
+
+            static size_t hash(const tinyobj::index_t &key)
+            {
+                uint64_t h = static_cast<uint32_t>(key.vertex_index) * 0x9E3779B97F4A7C15ull;
+                h ^= static_cast<uint32_t>(key.normal_index) * 0xC2B2AE3D27D4EB4Full;
+                h ^= static_cast<uint32_t>(key.texcoord_index) * 0x165667B19E3779F9ull;
+                return static_cast<size_t>(h ^ (h >> 32));
+            }
+
+            void grow()
+            {
+                std::vector<Slot> old = std::move(slots);
+                slots.assign(old.size() * 2, Slot{});
+                const size_t mask = slots.size() - 1;
+                for (const Slot &slot : old)
+                {
+                    if (slot.vertex == EMPTY)
+                    {
+                        continue;
+                    }
+                    size_t i = hash(slot.key) & mask;
+                    while (slots[i].vertex != EMPTY)
+                    {
+                        i = (i + 1) & mask;
+                    }
+                    slots[i] = slot;
+                }
+            }
+
+            std::vector<Slot> slots;
+            size_t count = 0;
+        };
+
+        Model::Vertex makeVertex(const tinyobj::attrib_t &attrib, const tinyobj::index_t &index)
+        {
+            Model::Vertex vertex{};
+
+            if (index.vertex_index >= 0)
+            {
+                vertex.position = {
+                    attrib.vertices[3 * index.vertex_index + 0],
+                    attrib.vertices[3 * index.vertex_index + 1],
+                    attrib.vertices[3 * index.vertex_index + 2],
+                };
+
+                vertex.color = {
+                    attrib.colors[3 * index.vertex_index + 0],
+                    attrib.colors[3 * index.vertex_index + 1],
+                    attrib.colors[3 * index.vertex_index + 2],
+                };
+            }
+
+            if (index.normal_index >= 0)
+            {
+                vertex.normal = {
+                    attrib.normals[3 * index.normal_index + 0],
+                    attrib.normals[3 * index.normal_index + 1],
+                    attrib.normals[3 * index.normal_index + 2],
+                };
+            }
+
+            if (index.texcoord_index >= 0)
+            {
+                vertex.uv = {
+                    attrib.texcoords[2 * index.texcoord_index + 0],
+                    attrib.texcoords[2 * index.texcoord_index + 1],
+                };
+            }
+
+            return vertex;
+        }
 
-    Model::Model(Device &device, const Model::Builder &builder) : device{device}
+        // Appends the shape's deduplicated vertices, indices are relative to vertices.size() on entry
+        void appendShape(const tinyobj::attrib_t &attrib, const tinyobj::shape_t &shape, IndexTripletMap &uniqueVertices,
+                         std::vector<Model::Vertex> &vertices, std::vector<uint32_t> &indices)
+        {
+            for (const auto &index : shape.mesh.indices)
+            {
+                const uint32_t newVertex = static_cast<uint32_t>(vertices.size());
+                const uint32_t vertex = uniqueVertices.findOrInsert(index, newVertex);
+                if (vertex == newVertex)
+                {
+                    vertices.push_back(makeVertex(attrib, index));
+                }
+                indices.push_back(vertex);
+            }
+        }
+    }
+
+    Model::Model(Device &device, UploadManager &uploadManager, const Model::Builder &builder) : Model{device, getMeshView(builder), uploadManager}
+    {
+    }
+
+    Model::Model(Device &device, const MeshView &mesh, UploadManager &uploadManager) : device{device}, vertexFormat{mesh.vertexFormat}
     {
-        createVertexBuffers(builder.vertices);
-        createIndexBuffers(builder.indices);
+        createBuffers(mesh, uploadManager);
     }
 
     Model::~Model() {}
 
     std::unique_ptr<Model> Model::createModelFromFile(
-        Device &device, const std::string &filePath)
+        Device &device, UploadManager &uploadManager, const std::string &filePath)
     {
+        const std::filesystem::path cachePath = getMeshCachePath(filePath);
+
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        MappedFile cache;
+        if (getSourceStamp(filePath, sourceSize, sourceWriteTime) && cache.open(cachePath) && cache.getSize() >= sizeof(MeshCacheHeader))
+        {
+            MeshCacheHeader header;
+            std::memcpy(&header, cache.getData(), sizeof(header));
+
+            const uint64_t vertexBytes = static_cast<uint64_t>(header.vertexSize) * header.vertexCount;
+            const uint64_t indexBytes = static_cast<uint64_t>(header.indexCount) * sizeof(uint32_t);
+            const bool valid = header.magic == MESH_CACHE_MAGIC && header.version == MESH_CACHE_VERSION &&
+                               header.sourceSize == sourceSize && header.sourceWriteTime == sourceWriteTime &&
+                               header.vertexFormat == static_cast<uint32_t>(VertexFormat::Standard) && header.vertexSize == sizeof(Vertex) &&
+                               cache.getSize() == sizeof(MeshCacheHeader) + vertexBytes + indexBytes;
+            if (valid)
+            {
+                MeshView mesh{};
+                mesh.vertexFormat = VertexFormat::Standard;
+                mesh.vertices = cache.getData() + sizeof(MeshCacheHeader);
+                mesh.vertexSize = header.vertexSize;
+                mesh.vertexCount = header.vertexCount;
+                mesh.indices = reinterpret_cast<const uint32_t *>(cache.getData() + sizeof(MeshCacheHeader) + vertexBytes);
+                mesh.indexCount = header.indexCount;
+                mesh.boundingBox.min = {header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]};
+                mesh.boundingBox.max = {header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]};
+
+                std::cout << "Vertex count: " << mesh.vertexCount << " (mesh cache)" << std::endl;
+                // The constructor copies the data into staging memory, so the mapping can go right after
+                auto model = std::unique_ptr<Model>(new Model(device, mesh, uploadManager));
+                uploadManager.wait(model->getUploadTicket());
+                return model;
+            }
+        }
+        cache.close();
+
         Builder builder{};
         builder.loadModel(filePath);
         std::cout << "Vertex count: " << builder.vertices.size() << std::endl;
-        return std::make_unique<Model>(device, builder);
+        writeMeshCache(filePath, cachePath, builder);
+        auto model = std::make_unique<Model>(device, uploadManager, builder);
+        uploadManager.wait(model->getUploadTicket());
+        return model;
     }
 
-    void Model::createVertexBuffers(const std::vector<Vertex> &vertices)
+    std::filesystem::path Model::getMeshCachePath(const std::string &filepath)
     {
-        vertexCount = static_cast<uint32_t>(vertices.size());
-        assert(vertexCount >= 3 && "Vertex count must be ");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
+        // Models with the same name in different folders get different cache files
+        const std::string absolute = std::filesystem::absolute(filepath).lexically_normal().string();
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : absolute)
+        {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
 
-        Buffer stagingBuffer(
-            device,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+        return std::filesystem::path{MESH_CACHE_DIRECTORY} / (std::filesystem::path{filepath}.filename().string() + "." + hex + ".mesh");
+    }
+
+    void Model::writeMeshCache(const std::string &filepath, const std::filesystem::path &cachePath, const Model::Builder &builder)
+    {
+        MeshCacheHeader header{};
+        header.magic = MESH_CACHE_MAGIC;
+        header.version = MESH_CACHE_VERSION;
+        if (builder.vertexFormat != VertexFormat::Standard || !getSourceStamp(filepath, header.sourceSize, header.sourceWriteTime))
+        {
+            return;
+        }
+        header.vertexFormat = static_cast<uint32_t>(VertexFormat::Standard);
+        header.vertexSize = sizeof(Vertex);
+        header.vertexCount = static_cast<uint32_t>(builder.vertices.size());
+        header.indexCount = static_cast<uint32_t>(builder.indices.size());
+        const BoundingBox bounds = builder.computeBoundingBox();
+        for (int i = 0; i < 3; i++)
+        {
+            header.boundsMin[i] = bounds.min[i];
+            header.boundsMax[i] = bounds.max[i];
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(cachePath.parent_path(), error);
+
+        // Written to a temporary file and renamed, a crash never leaves a truncated cache behind
+        std::filesystem::path tempPath = cachePath;
+        tempPath += ".tmp";
+        {
+            std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(builder.vertices.data()), static_cast<std::streamsize>(builder.vertices.size() * sizeof(Vertex)));
+            file.write(reinterpret_cast<const char *>(builder.indices.data()), static_cast<std::streamsize>(builder.indices.size() * sizeof(uint32_t)));
+            if (!file)
+            {
+                std::cerr << "mesh cache: failed to write " << tempPath.string() << std::endl;
+                return;
+            }
+        }
+        std::filesystem::rename(tempPath, cachePath, error);
+        if (error)
+        {
+            std::cerr << "mesh cache: failed to write " << cachePath.string() << std::endl;
+            std::filesystem::remove(tempPath, error);
+        }
+    }
 
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)vertices.data());
+    Model::MeshView Model::getMeshView(const Model::Builder &builder)
+    {
+        MeshView mesh{};
+        mesh.vertexFormat = builder.vertexFormat;
+        if (builder.vertexFormat == VertexFormat::Packed)
+        {
+            mesh.vertices = builder.packedVertices.data();
+            mesh.vertexSize = sizeof(PackedVertex);
+            mesh.vertexCount = static_cast<uint32_t>(builder.packedVertices.size());
+        }
+        else
+        {
+            mesh.vertices = builder.vertices.data();
+            mesh.vertexSize = sizeof(Vertex);
+            mesh.vertexCount = static_cast<uint32_t>(builder.vertices.size());
+        }
+        mesh.indices = builder.indices.data();
+        mesh.indexCount = static_cast<uint32_t>(builder.indices.size());
+        mesh.boundingBox = builder.computeBoundingBox();
+        return mesh;
+    }
+
+    void Model::createBuffers(const MeshView &mesh, UploadManager &uploadManager)
+    {
+        boundingBox = mesh.boundingBox;
+        createVertexBuffers(mesh.vertices, mesh.vertexSize, mesh.vertexCount, uploadManager);
+        createIndexBuffers(mesh.indices, mesh.indexCount, uploadManager);
+    }
+
+    void Model::createVertexBuffers(const void *vertices, uint32_t vertexSize, uint32_t count, UploadManager &uploadManager)
+    {
+        vertexCount = count;
+        assert(vertexCount >= 3 && "Vertex count must be ");
+        VkDeviceSize bufferSize = vertexSize * vertexCount;
 
         vertexBuffer = std::make_unique<Buffer>(
             device,
@@ -71,38 +353,25 @@ namespace VoxelEngine
             vertexCount,
             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-        device.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+        uploadTicket = uploadManager.uploadBuffer(vertices, bufferSize, vertexBuffer->getBuffer());
     }
 
-    void Model::createIndexBuffers(const std::vector<uint32_t> &indices)
+    void Model::createIndexBuffers(const uint32_t *indices, uint32_t count, UploadManager &uploadManager)
     {
-        indexCount = static_cast<uint32_t>(indices.size());
+        indexCount = count;
         hasIndexBuffer = indexCount > 0;
         if (!hasIndexBuffer)
             return;
         VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
         uint32_t indexSize = sizeof(indices[0]);
 
-        Buffer stagingBuffer(
-            device,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)indices.data());
-        stagingBuffer.unmap();
-
         indexBuffer = std::make_unique<Buffer>(
             device,
             indexSize,
             indexCount,
             VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-        device.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+        uploadTicket = uploadManager.uploadBuffer(indices, bufferSize, indexBuffer->getBuffer());
     }
 
     void Model::bind(VkCommandBuffer commandBuffer)
@@ -117,15 +386,15 @@ namespace VoxelEngine
         }
     }
 
-    void Model::draw(VkCommandBuffer commandBuffer)
+    void Model::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance)
     {
         if (hasIndexBuffer)
         {
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+            vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
         }
         else
         {
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+            vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
         }
     }
 
@@ -150,7 +419,44 @@ namespace VoxelEngine
         return attributeDescriptions;
     }
 
-    void Model::Builder::loadModel(const std::string &filepath)
+    static_assert(sizeof(Model::PackedVertex) == 8, "PackedVertex must stay two 32-bit words");
+
+    Model::PackedVertex Model::PackedVertex::pack(const glm::ivec3 &position, uint32_t face, uint32_t ao, uint32_t layer, const glm::vec3 &color)
+    {
+        assert(position.x >= 0 && position.x < 64 && position.y >= 0 && position.y < 64 && position.z >= 0 && position.z < 64 &&
+               "Packed vertex position out of range");
+
+        const glm::vec3 tint = glm::clamp(color, glm::vec3{0.f}, glm::vec3{1.f});
+        const uint32_t r = static_cast<uint32_t>(tint.x * 31.f + .5f);
+        const uint32_t g = static_cast<uint32_t>(tint.y * 63.f + .5f);
+        const uint32_t b = static_cast<uint32_t>(tint.z * 31.f + .5f);
+
+        PackedVertex vertex{};
+        vertex.data0 = static_cast<uint32_t>(position.x) | (static_cast<uint32_t>(position.y) << 6) |
+                       (static_cast<uint32_t>(position.z) << 12) | ((face & 0x7) << 18) | ((ao & 0x3) << 21);
+        vertex.data1 = (layer & 0xFFFF) | (r << 16) | (g << 21) | (b << 27);
+        return vertex;
+    }
+
+    std::vector<VkVertexInputBindingDescription> Model::PackedVertex::getBindingDescriptions()
+    {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(PackedVertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> Model::PackedVertex::getAttributeDescriptions()
+    {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32_UINT, 0});
+
+        return attributeDescriptions;
+    }
+
+    void Model::Builder::loadModel(const std::string &filepath, bool parallel)
     {
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
@@ -161,57 +467,103 @@ namespace VoxelEngine
         {
             throw std::runtime_error(warn + err);
         }
+        loadShapes(attrib, shapes, parallel);
+    }
 
+    void Model::Builder::loadShapes(const tinyobj::attrib_t &attrib, const std::vector<tinyobj::shape_t> &shapes, bool parallel)
+    {
         vertices.clear();
+        packedVertices.clear();
         indices.clear();
+        vertexFormat = VertexFormat::Standard;
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        size_t indexCount = 0;
         for (const auto &shape : shapes)
         {
-            for (const auto &index : shape.mesh.indices)
+            indexCount += shape.mesh.indices.size();
+        }
+        // Most positions end up as exactly one vertex, seams add a few more
+        const size_t positionCount = attrib.vertices.size() / 3;
+
+        const uint32_t threadCount = std::min<uint32_t>(std::max(std::thread::hardware_concurrency(), 1u), static_cast<uint32_t>(shapes.size()));
+        if (!parallel || threadCount < 2)
+        {
+            IndexTripletMap uniqueVertices{positionCount};
+            vertices.reserve(positionCount);
+            indices.reserve(indexCount);
+            for (const auto &shape : shapes)
             {
-                Vertex vertex{};
+                appendShape(attrib, shape, uniqueVertices, vertices, indices);
+            }
+            return;
+        }
 
-                if (index.vertex_index >= 0)
-                {
-                    vertex.position = {
-                        attrib.vertices[3 * index.vertex_index + 0],
-                        attrib.vertices[3 * index.vertex_index + 1],
-                        attrib.vertices[3 * index.vertex_index + 2],
-                    };
-
-                    vertex.color = {
-                        attrib.colors[3 * index.vertex_index + 0],
-                        attrib.colors[3 * index.vertex_index + 1],
-                        attrib.colors[3 * index.vertex_index + 2],
-                    };
-                    
-                }
+        struct ShapeResult
+        {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+        };
+        std::vector<ShapeResult> results(shapes.size());
+        std::atomic<size_t> nextShape{0};
 
-                if (index.normal_index >= 0)
-                {
-                    vertex.normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2],
-                    };
-                }
+        auto worker = [&]
+        {
+            for (size_t i = nextShape++; i < shapes.size(); i = nextShape++)
+            {
+                const size_t shapeIndexCount = shapes[i].mesh.indices.size();
+                // A closed triangle mesh has about one vertex per six indices
+                IndexTripletMap uniqueVertices{shapeIndexCount / 6};
+                results[i].vertices.reserve(shapeIndexCount / 6);
+                results[i].indices.reserve(shapeIndexCount);
+                appendShape(attrib, shapes[i], uniqueVertices, results[i].vertices, results[i].indices);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < threadCount; i++)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
 
-                if (index.texcoord_index >= 0)
-                {
-                    vertex.uv = {
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        attrib.texcoords[2 * index.texcoord_index + 1],
-                    };
-                }
+        size_t vertexCount = 0;
+        for (const auto &result : results)
+        {
+            vertexCount += result.vertices.size();
+        }
+        vertices.reserve(vertexCount);
+        indices.reserve(indexCount);
+        for (const auto &result : results)
+        {
+            const uint32_t offset = static_cast<uint32_t>(vertices.size());
+            vertices.insert(vertices.end(), result.vertices.begin(), result.vertices.end());
+            for (uint32_t index : result.indices)
+            {
+                indices.push_back(index + offset);
+            }
+        }
+    }
 
-                if (uniqueVertices.count(vertex) == 0)
-                {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
-                indices.push_back(uniqueVertices[vertex]);
+    BoundingBox Model::Builder::computeBoundingBox() const
+    {
+        BoundingBox box{};
+        if (vertexFormat == VertexFormat::Packed)
+        {
+            for (const auto &vertex : packedVertices)
+            {
+                box.expand(glm::vec3{vertex.getPosition()});
+            }
+        }
+        else
+        {
+            for (const auto &vertex : vertices)
+            {
+                box.expand(vertex.position);
             }
         }
+        return box;
     }
 }
\ No newline at end of file
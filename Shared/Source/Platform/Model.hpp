@@ -2,6 +2,8 @@
 
 #include "Device.hpp"
 #include "Buffer.hpp"
+#include "UploadManager.hpp"
+#include "Utils/BoundingBox.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -9,14 +11,36 @@
 #include <glm/glm.hpp>
 
 // std
+#include <filesystem>
 #include <memory>
+#include <string>
 #include <vector>
 
+namespace tinyobj
+{
+    struct attrib_t;
+    struct shape_t;
+}
+
 namespace VoxelEngine
 {
+    // Vertex and index buffers for one mesh.
+    //
+    // createModelFromFile() imports OBJ files once and writes the result to a binary cache in
+    // MESH_CACHE_DIRECTORY. Later loads map the cache file and copy its vertex and index blobs
+    // straight into the upload staging ring. The cache is rebuilt when the source size or modification
+    // time no longer matches the header.
     class Model
     {
     public:
+        static constexpr const char *MESH_CACHE_DIRECTORY = "MeshCache";
+
+        enum class VertexFormat
+        {
+            Standard, // Vertex, 44 bytes
+            Packed    // PackedVertex, 8 bytes, chunk-local voxel geometry only
+        };
+
         struct Vertex
         {
             glm::vec3 position{};
@@ -34,31 +58,93 @@ namespace VoxelEngine
             }
         };
 
+        // Compact voxel vertex. Positions are chunk-local integer corners (0..32), the normal comes
+        // from the face index and uvs are derived from the position in the shader.
+        //   data0: x:6 y:6 z:6 face:3 ao:2
+        //   data1: texture layer:16 tint:16 (RGB565)
+        struct PackedVertex
+        {
+            uint32_t data0 = 0;
+            uint32_t data1 = 0;
+
+            static PackedVertex pack(const glm::ivec3 &position, uint32_t face, uint32_t ao, uint32_t layer, const glm::vec3 &color);
+
+            glm::ivec3 getPosition() const
+            {
+                return {static_cast<int>(data0 & 0x3F), static_cast<int>((data0 >> 6) & 0x3F), static_cast<int>((data0 >> 12) & 0x3F)};
+            }
+            uint32_t getFace() const { return (data0 >> 18) & 0x7; }
+            uint32_t getAo() const { return (data0 >> 21) & 0x3; }
+            uint32_t getLayer() const { return data1 & 0xFFFF; }
+
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+        };
+
         struct Builder
         {
             std::vector<Vertex> vertices{};
+            std::vector<PackedVertex> packedVertices{};
             std::vector<uint32_t> indices{};
-
-            void loadModel(const std::string &filepath);
+            // Selects which of the two vertex arrays gets uploaded
+            VertexFormat vertexFormat = VertexFormat::Standard;
+
+            // Vertices are deduplicated by their OBJ position/normal/texcoord index triplet. With
+            // parallel each shape is processed on its own thread, vertices are then only shared
+            // within a shape
+            void loadModel(const std::string &filepath, bool parallel = false);
+            // loadModel() on an already parsed OBJ
+            void loadShapes(const tinyobj::attrib_t &attrib, const std::vector<tinyobj::shape_t> &shapes, bool parallel = false);
+            // Local space bounds of whichever vertex array vertexFormat selects
+            BoundingBox computeBoundingBox() const;
         };
 
-        Model(Device &device, const Model::Builder &builder);
+        // Records the uploads without waiting, the model may only be drawn once its ticket completes
+        Model(Device &device, UploadManager &uploadManager, const Model::Builder &builder);
         ~Model();
 
         Model(const Model &) = delete;
         Model &operator=(const Model &) = delete;
 
+        // Blocks until the uploads have finished, the model can be drawn right away
         static std::unique_ptr<Model> createModelFromFile(
-            Device &device, const std::string &filepath);
+            Device &device, UploadManager &uploadManager, const std::string &filepath);
 
         void bind(VkCommandBuffer commandBuffer);
-        void draw(VkCommandBuffer commandBuffer);
+        // Instances are numbered from firstInstance in the vertex shader's gl_InstanceIndex
+        void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+        VertexFormat getVertexFormat() const { return vertexFormat; }
+        UploadManager::Ticket getUploadTicket() const { return uploadTicket; }
+        const BoundingBox &getBoundingBox() const { return boundingBox; }
 
     private:
-        void createVertexBuffers(const std::vector<Vertex> &vertices);
-        void createIndexBuffers(const std::vector<uint32_t> &indices);
+        // Borrowed vertex and index data, from a Builder or from a mapped mesh cache file
+        struct MeshView
+        {
+            VertexFormat vertexFormat = VertexFormat::Standard;
+            const void *vertices = nullptr;
+            uint32_t vertexSize = 0;
+            uint32_t vertexCount = 0;
+            const uint32_t *indices = nullptr;
+            uint32_t indexCount = 0;
+            BoundingBox boundingBox{};
+        };
+
+        Model(Device &device, const MeshView &mesh, UploadManager &uploadManager);
+
+        static MeshView getMeshView(const Model::Builder &builder);
+        static std::filesystem::path getMeshCachePath(const std::string &filepath);
+        static void writeMeshCache(const std::string &filepath, const std::filesystem::path &cachePath, const Model::Builder &builder);
+
+        void createBuffers(const MeshView &mesh, UploadManager &uploadManager);
+        void createVertexBuffers(const void *vertices, uint32_t vertexSize, uint32_t count, UploadManager &uploadManager);
+        void createIndexBuffers(const uint32_t *indices, uint32_t count, UploadManager &uploadManager);
 
         Device &device;
+        VertexFormat vertexFormat;
+        UploadManager::Ticket uploadTicket = UploadManager::COMPLETED_TICKET;
+        BoundingBox boundingBox{};
 
         std::unique_ptr<Buffer> vertexBuffer;
         uint32_t vertexCount;
@@ -4,6 +4,9 @@
 
 // std
 #include <cassert>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
@@ -47,6 +50,23 @@ namespace VoxelEngine
         return buffer;
     }
 
+    std::vector<uint32_t> Pipeline::loadSpirv(Device &device, const std::string &filepath, const std::vector<ShaderDefine> &defines)
+    {
+        if (std::filesystem::path{filepath}.extension() != ".spv")
+        {
+            return device.shaderManager().getSpirv(filepath, defines);
+        }
+
+        auto bytes = readFile(filepath);
+        if (bytes.empty() || bytes.size() % sizeof(uint32_t) != 0)
+        {
+            throw std::runtime_error("invalid SPIR-V file: " + filepath);
+        }
+        std::vector<uint32_t> code(bytes.size() / sizeof(uint32_t));
+        std::memcpy(code.data(), bytes.data(), bytes.size());
+        return code;
+    }
+
     void Pipeline::createGraphicsPipeline(
         const std::string &vertFilepath,
         const std::string &fragFilepath,
@@ -59,8 +79,8 @@ namespace VoxelEngine
             configInfo.renderPass != VK_NULL_HANDLE &&
             "Cannot create graphics pipeline: no renderPass provided in configInfo");
 
-        auto vertCode = readFile(vertFilepath);
-        auto fragCode = readFile(fragFilepath);
+        auto vertCode = loadSpirv(device, vertFilepath, configInfo.shaderDefines);
+        auto fragCode = loadSpirv(device, fragFilepath, configInfo.shaderDefines);
 
         createShaderModule(vertCode, &vertexShaderModule);
         createShaderModule(fragCode, &fragmentShaderModule);
@@ -81,8 +101,8 @@ namespace VoxelEngine
         shaderStages[1].pNext = nullptr;
         shaderStages[1].pSpecializationInfo = nullptr;
 
-        auto bindingDescriptions = Model::Vertex::getBindingDescriptions();
-        auto attributeDescriptions = Model::Vertex::getAttributeDescriptions();
+        auto &bindingDescriptions = configInfo.bindingDescriptions;
+        auto &attributeDescriptions = configInfo.attributeDescriptions;
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         vertexInputInfo.vertexAttributeDescriptionCount =
@@ -111,9 +131,10 @@ namespace VoxelEngine
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
+        const auto start = std::chrono::high_resolution_clock::now();
         if (vkCreateGraphicsPipelines(
                 device.device(),
-                VK_NULL_HANDLE,
+                device.pipelineCache(),
                 1,
                 &pipelineInfo,
                 nullptr,
@@ -121,14 +142,16 @@ namespace VoxelEngine
         {
             throw std::runtime_error("failed to create graphics pipeline");
         }
+        const auto end = std::chrono::high_resolution_clock::now();
+        device.recordPipelineCreation(std::chrono::duration<double, std::micro>(end - start).count());
     }
 
-    void Pipeline::createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule)
+    void Pipeline::createShaderModule(const std::vector<uint32_t> &code, VkShaderModule *shaderModule)
     {
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+        createInfo.codeSize = code.size() * sizeof(uint32_t);
+        createInfo.pCode = code.data();
 
         if (vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
         {
@@ -211,6 +234,9 @@ namespace VoxelEngine
         configInfo.dynamicStateInfo.dynamicStateCount =
             static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
         configInfo.dynamicStateInfo.flags = 0;
+
+        configInfo.bindingDescriptions = Model::Vertex::getBindingDescriptions();
+        configInfo.attributeDescriptions = Model::Vertex::getAttributeDescriptions();
     }
 
 }
\ No newline at end of file
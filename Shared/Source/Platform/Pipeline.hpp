@@ -8,6 +8,8 @@
 namespace VoxelEngine
 {
     struct PipelineConfigInfo {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
         VkPipelineViewportStateCreateInfo viewportInfo;
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
         VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -20,6 +22,8 @@ namespace VoxelEngine
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
         uint32_t subpass = 0;
+        // Applied to both stages when they are compiled from GLSL
+        std::vector<ShaderDefine> shaderDefines{};
     };
 
     class Pipeline
@@ -37,16 +41,18 @@ namespace VoxelEngine
 
         void bind(VkCommandBuffer commandBuffer);
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
+        static std::vector<char> readFile(const std::string& filepath);
+        // Precompiled .spv files are read as they are, anything else is GLSL for the ShaderManager
+        static std::vector<uint32_t> loadSpirv(Device& device, const std::string& filepath, const std::vector<ShaderDefine>& defines = {});
 
         private:
-        static std::vector<char> readFile(const std::string& filepath);
 
         void createGraphicsPipeline(
             const std::string& vertexShaderPath, 
             const std::string& fragmentShaderPath,
             const PipelineConfigInfo& configInfo);
 
-        void createShaderModule(const std::vector<char>& code,VkShaderModule* shaderModule);
+        void createShaderModule(const std::vector<uint32_t>& code,VkShaderModule* shaderModule);
 
         Device& device;
         VkPipeline graphicsPipeline;
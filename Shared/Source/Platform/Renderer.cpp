@@ -7,15 +7,33 @@
 namespace VoxelEngine
 {
 
-    Renderer::Renderer(Window& window, Device& device) : window{window}, device{device}
+    Renderer::Renderer(Window& window, Device& device, uint32_t framesInFlight)
+        : window{window}, device{device}, framesInFlight{framesInFlight}, frameTimeline{device, framesInFlight},
+          frameValues(framesInFlight, 0)
     {
+        if (framesInFlight < 1 || framesInFlight > SwapChain::MAX_FRAMES_IN_FLIGHT)
+        {
+            throw std::runtime_error("frames in flight must be between 1 and SwapChain::MAX_FRAMES_IN_FLIGHT!");
+        }
+
         recreateSwapChain();
         createCommandBuffers();
+        createSecondaryPools();
+
+        // Destruction is deferred from here on, until the frame that could still use it is done
+        device.deletionQueue().setCurrentFrame(frameTimeline.getSubmittedValue() + 1);
     }
 
     Renderer::~Renderer()
     {
+        // Command buffers must not be freed while the GPU still executes them
+        frameTimeline.wait(frameTimeline.getSubmittedValue());
+        destroySecondaryPools();
         freeCommandBuffers();
+        retiredSwapChains.clear();
+
+        device.deletionQueue().flush();
+        device.deletionQueue().setCurrentFrame(0);
     }
 
     void Renderer::recreateSwapChain()
@@ -27,28 +45,52 @@ namespace VoxelEngine
             glfwWaitEvents();
         }
 
-        vkDeviceWaitIdle(device.device());
+        swapChainConfigChanged = false;
 
         if (swapChain == nullptr)
         {
-            swapChain = std::make_unique<SwapChain>(device, extent);
+            swapChain = std::make_unique<SwapChain>(device, extent, swapChainConfig);
         }
         else
         {
             std::shared_ptr<SwapChain> oldSwapChain = std::move(swapChain);
-            swapChain = std::make_unique<SwapChain>(device, extent, oldSwapChain);
+            swapChain = std::make_unique<SwapChain>(device, extent, oldSwapChain, swapChainConfig);
             
             if(!oldSwapChain->compareSwapFormats(*swapChain.get()))
             {
                 throw std::runtime_error("Swap chain image or depth format has changed!");
             }
+
+            // Frames still in flight keep rendering to the old images. Their presents are queued
+            // ahead of the first frame on the new swapchain, once that one finishes it can go
+            retiredSwapChains.push_back({std::move(oldSwapChain), frameTimeline.getSubmittedValue() + 1});
         }
 
+        // No frame has used the new images yet
+        imageValues.assign(swapChain->imageCount(), 0);
+    }
+
+    void Renderer::destroyRetiredSwapChains()
+    {
+        std::erase_if(retiredSwapChains, [this](const RetiredSwapChain &retired)
+                      { return frameTimeline.isComplete(retired.retireValue); });
+    }
+
+    void Renderer::setPresentMode(VkPresentModeKHR presentMode)
+    {
+        swapChainConfig.presentMode = presentMode;
+        swapChainConfigChanged = true;
+    }
+
+    void Renderer::setImageCount(uint32_t imageCount)
+    {
+        swapChainConfig.imageCount = imageCount;
+        swapChainConfigChanged = true;
     }
 
     void Renderer::createCommandBuffers()
     {
-        commandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        commandBuffers.resize(framesInFlight);
 
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -69,11 +111,101 @@ namespace VoxelEngine
         commandBuffers.clear();
     }
 
+    void Renderer::createSecondaryPools()
+    {
+        secondaryPools.resize(framesInFlight * MAX_RECORDING_SLOTS);
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily;
+        // Only ever reset as a whole
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        for (auto &pool : secondaryPools)
+        {
+            if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &pool.commandPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create secondary command pool!");
+            }
+        }
+    }
+
+    void Renderer::destroySecondaryPools()
+    {
+        // Destroying a pool frees its command buffers
+        for (auto &pool : secondaryPools)
+        {
+            vkDestroyCommandPool(device.device(), pool.commandPool, nullptr);
+        }
+        secondaryPools.clear();
+    }
+
+    VkCommandBuffer Renderer::beginSecondaryCommandBuffer(uint32_t slot)
+    {
+        assert(isFrameStarted && "Cannot begin secondary command buffer when frame is not in progress");
+        assert(slot < MAX_RECORDING_SLOTS && "Recording slot out of range");
+
+        SecondaryPool &pool = secondaryPools[currentFrameIndex * MAX_RECORDING_SLOTS + slot];
+        if (pool.usedCount == pool.commandBuffers.size())
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = pool.commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate secondary command buffer!");
+            }
+            pool.commandBuffers.push_back(commandBuffer);
+        }
+        VkCommandBuffer commandBuffer = pool.commandBuffers[pool.usedCount++];
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = swapChain->getRenderPass();
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = swapChain->getFrameBuffer(currentImageIndex);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording secondary command buffer!");
+        }
+
+        // Dynamic state is not inherited from the primary
+        setViewportAndScissor(commandBuffer);
+        return commandBuffer;
+    }
+
+    void Renderer::endSecondaryCommandBuffer(VkCommandBuffer commandBuffer)
+    {
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record secondary command buffer!");
+        }
+    }
+
     VkCommandBuffer Renderer::beginFrame()
     {
         assert(!isFrameStarted && "Cannot call beginFrame while already in progress");
-        
-        auto result = swapChain->acquireNextImage(&currentImageIndex);
+
+        currentFrameTimestamps.start = std::chrono::steady_clock::now();
+        if (swapChainConfigChanged)
+        {
+            recreateSwapChain();
+        }
+
+        // Everything indexed by this frame, including its acquire semaphore, is free after this
+        frameTimeline.wait(frameValues[currentFrameIndex]);
+
+        auto result = swapChain->acquireNextImage(currentFrameIndex, &currentImageIndex);
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
         {
@@ -88,6 +220,23 @@ namespace VoxelEngine
 
         isFrameStarted = true;
 
+        // With more images than frames in flight an image can come back while its last frame still renders
+        frameTimeline.wait(imageValues[currentImageIndex]);
+
+        destroyRetiredSwapChains();
+        device.deletionQueue().collect(frameTimeline.getCompletedValue());
+
+        // This frame's previous submission has finished, so have its secondary buffers
+        for (uint32_t slot = 0; slot < MAX_RECORDING_SLOTS; slot++)
+        {
+            SecondaryPool &pool = secondaryPools[currentFrameIndex * MAX_RECORDING_SLOTS + slot];
+            if (pool.usedCount > 0)
+            {
+                vkResetCommandPool(device.device(), pool.commandPool, 0);
+                pool.usedCount = 0;
+            }
+        }
+
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -111,7 +260,22 @@ namespace VoxelEngine
             throw std::runtime_error("failed to record command buffer!");
         }
 
-        auto result = swapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+        swapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex, currentFrameIndex, frameTimeline);
+        frameValues[currentFrameIndex] = frameTimeline.getSubmittedValue();
+        imageValues[currentImageIndex] = frameTimeline.getSubmittedValue();
+        device.deletionQueue().setCurrentFrame(frameTimeline.getSubmittedValue() + 1);
+        currentFrameTimestamps.submit = std::chrono::steady_clock::now();
+
+        // FIFO can block here until an image is free, that time is part of the latency
+        auto result = swapChain->presentImage(&currentImageIndex);
+        currentFrameTimestamps.present = std::chrono::steady_clock::now();
+
+        lastFrameTimestamps = currentFrameTimestamps;
+        latencyStats.frameCount++;
+        latencyStats.startToSubmitMicroseconds += std::chrono::duration<double, std::micro>(
+            currentFrameTimestamps.submit - currentFrameTimestamps.start).count();
+        latencyStats.submitToPresentMicroseconds += std::chrono::duration<double, std::micro>(
+            currentFrameTimestamps.present - currentFrameTimestamps.submit).count();
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.wasWindowResized())
         {
@@ -120,14 +284,14 @@ namespace VoxelEngine
         }
         else if (result != VK_SUCCESS)
         {
-            throw std::runtime_error("failed to submit command buffer!");
+            throw std::runtime_error("failed to present swap chain image!");
         }
 
         isFrameStarted = false;
-        currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+        currentFrameIndex = (currentFrameIndex + 1) % framesInFlight;
     }
 
-    void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+    void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
     {
         assert(isFrameStarted && "Cannot call beginSwapChainRenderPass when frame is not in progress");
         assert(commandBuffer == getCurrentCommandBuffer() && "Cannot begin render pass on command buffer from another frame");
@@ -146,8 +310,17 @@ namespace VoxelEngine
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
 
+        // Secondary buffers set their own
+        if (contents == VK_SUBPASS_CONTENTS_INLINE)
+        {
+            setViewportAndScissor(commandBuffer);
+        }
+    }
+
+    void Renderer::setViewportAndScissor(VkCommandBuffer commandBuffer)
+    {
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
@@ -3,32 +3,83 @@
 #include "Window.hpp"
 #include "Device.hpp"
 #include "SwapChain.hpp"
+#include "FrameTimeline.hpp"
 #include "Model.hpp"
 
 #include <cassert>
+#include <chrono>
 #include <memory>
 #include <vector>
 
 namespace VoxelEngine
 {
+    // CPU side of one frame, from beginFrame() to the return of vkQueuePresentKHR
+    struct FrameTimestamps
+    {
+        std::chrono::steady_clock::time_point start{};
+        std::chrono::steady_clock::time_point submit{};
+        std::chrono::steady_clock::time_point present{};
+    };
+
+    // Sums over frameCount frames, to compare present modes and image counts
+    struct LatencyStats
+    {
+        uint32_t frameCount = 0;
+        double startToSubmitMicroseconds = 0.0;
+        double submitToPresentMicroseconds = 0.0;
+    };
+
     class Renderer
     {
         public:
-        Renderer(Window& window, Device& device);
+        // Command pools for secondary command buffers, per frame in flight
+        static constexpr uint32_t MAX_RECORDING_SLOTS = 8;
+
+        // framesInFlight trades latency for throughput, 1 to SwapChain::MAX_FRAMES_IN_FLIGHT
+        Renderer(Window& window, Device& device, uint32_t framesInFlight = SwapChain::DEFAULT_FRAMES_IN_FLIGHT);
         ~Renderer();
 
         Renderer(const Renderer &) = delete;
         Renderer& operator=(const Renderer &) = delete;
 
+        // Handed from each swapchain to the next, pipelines built against it survive recreation
         VkRenderPass getSwapChainRenderPass() const { return swapChain->getRenderPass(); }
         float getAspectRatio() const { return swapChain->extentAspectRatio(); }
+        VkExtent2D getSwapChainExtent() const { return swapChain->getSwapChainExtent(); }
+        VkFormat getDepthFormat() const { return swapChain->getDepthFormat(); }
         bool isFrameInProgress() const { return isFrameStarted; }
+        // Per-frame resources only need this many copies, getFrameIndex() stays below it
+        uint32_t getFramesInFlight() const { return framesInFlight; }
+        // Also accumulates the CPU time beginFrame() spent waiting for the GPU
+        FrameTimeline &getFrameTimeline() { return frameTimeline; }
+
+        // Both take effect when the next frame begins, the swapchain is recreated then. The actual
+        // mode falls back to FIFO when the surface lacks the requested one
+        void setPresentMode(VkPresentModeKHR presentMode);
+        void setImageCount(uint32_t imageCount);
+        VkPresentModeKHR getPresentMode() const { return swapChain->getPresentMode(); }
+        uint32_t getImageCount() const { return static_cast<uint32_t>(swapChain->imageCount()); }
+
+        const FrameTimestamps &getLastFrameTimestamps() const { return lastFrameTimestamps; }
+        const LatencyStats &getLatencyStats() const { return latencyStats; }
+        void resetLatencyStats() { latencyStats = {}; }
 
         VkCommandBuffer getCurrentCommandBuffer() const {
             assert(isFrameStarted && "Cannot get command buffer when frame is not in progress");
             return commandBuffers[currentFrameIndex];
         }
 
+        // Depth attachment of the image being rendered, in DEPTH_STENCIL_ATTACHMENT_OPTIMAL after the render pass
+        VkImage getCurrentDepthImage() const {
+            assert(isFrameStarted && "Cannot get depth image when frame is not in progress");
+            return swapChain->getDepthImage(currentImageIndex);
+        }
+
+        VkImageView getCurrentDepthImageView() const {
+            assert(isFrameStarted && "Cannot get depth image view when frame is not in progress");
+            return swapChain->getDepthImageView(currentImageIndex);
+        }
+
         int getFrameIndex() const {
             assert(isFrameStarted && "Cannot get frame index when frame is not in progress");
             return currentFrameIndex;
@@ -36,18 +87,59 @@ namespace VoxelEngine
 
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass may only execute secondary buffers
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+        // Begins a secondary buffer that continues the swapchain render pass, viewport and scissor
+        // already set. Each slot has its own command pool, so different slots can record on
+        // different threads at once but one slot must only be used by one thread at a time.
+        // The buffers are only valid until the frame ends
+        VkCommandBuffer beginSecondaryCommandBuffer(uint32_t slot);
+        void endSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
+
         private:
+        struct SecondaryPool
+        {
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> commandBuffers;
+            uint32_t usedCount = 0;
+        };
+
+        struct RetiredSwapChain
+        {
+            std::shared_ptr<SwapChain> swapChain;
+            FrameTimeline::Value retireValue = 0;
+        };
+
         void createCommandBuffers();
         void freeCommandBuffers();
+        void createSecondaryPools();
+        void destroySecondaryPools();
+        // Does not wait for the GPU, the old swapchain is retired until its frames are done
         void recreateSwapChain();
+        void destroyRetiredSwapChains();
+        void setViewportAndScissor(VkCommandBuffer commandBuffer);
 
         Window& window;
         Device& device;
+        uint32_t framesInFlight;
+        SwapChainConfig swapChainConfig{};
+        bool swapChainConfigChanged{false};
         std::unique_ptr<SwapChain> swapChain;
+        std::vector<RetiredSwapChain> retiredSwapChains;
         std::vector<VkCommandBuffer> commandBuffers;
+        // Indexed by frame * MAX_RECORDING_SLOTS + slot, reset when their frame begins again
+        std::vector<SecondaryPool> secondaryPools;
+
+        FrameTimeline frameTimeline;
+        // Timeline value of the last submission per frame index and per swapchain image
+        std::vector<FrameTimeline::Value> frameValues;
+        std::vector<FrameTimeline::Value> imageValues;
+
+        FrameTimestamps currentFrameTimestamps{};
+        FrameTimestamps lastFrameTimestamps{};
+        LatencyStats latencyStats{};
 
         uint32_t currentImageIndex;
         int currentFrameIndex{0};
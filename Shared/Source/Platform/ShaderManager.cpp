@@ -0,0 +1,209 @@
+#include "ShaderManager.hpp"
+
+#include "Pipeline.hpp"
+
+// libs
+#include <glslang/Public/ResourceLimits.h>
+#include <glslang/Public/ShaderLang.h>
+#include <SPIRV/GlslangToSpv.h>
+
+// std
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace VoxelEngine
+{
+    // Bump when the compile options below change, so old cache entries are not picked up
+    static constexpr uint32_t CACHE_VERSION = 1;
+    static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+    static EShLanguage getStage(const std::string &sourcePath)
+    {
+        const std::string extension = std::filesystem::path{sourcePath}.extension().string();
+        if (extension == ".vert")
+        {
+            return EShLangVertex;
+        }
+        if (extension == ".frag")
+        {
+            return EShLangFragment;
+        }
+        if (extension == ".comp")
+        {
+            return EShLangCompute;
+        }
+        throw std::runtime_error("unknown shader stage for: " + sourcePath);
+    }
+
+    ShaderManager::ShaderManager(std::filesystem::path cacheDirectory) : cacheDirectory{std::move(cacheDirectory)}
+    {
+        glslang::InitializeProcess();
+    }
+
+    ShaderManager::~ShaderManager()
+    {
+        glslang::FinalizeProcess();
+    }
+
+    std::string ShaderManager::buildPreamble(const std::vector<ShaderDefine> &defines)
+    {
+        std::string preamble;
+        for (const auto &define : defines)
+        {
+            preamble += "#define " + define.name + " " + define.value + "\n";
+        }
+        return preamble;
+    }
+
+    uint64_t ShaderManager::hashKey(const std::string &source, const std::string &preamble)
+    {
+        // FNV-1a, the preamble is separated by a zero byte so it cannot alias the source
+        uint64_t hash = 14695981039346656037ull ^ CACHE_VERSION;
+        auto mix = [&](const std::string &text)
+        {
+            for (unsigned char c : text)
+            {
+                hash = (hash ^ c) * 1099511628211ull;
+            }
+            hash = hash * 1099511628211ull;
+        };
+        mix(preamble);
+        mix(source);
+        return hash;
+    }
+
+    std::filesystem::path ShaderManager::getCachePath(const std::string &sourcePath, uint64_t key) const
+    {
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(key));
+        return cacheDirectory / (std::filesystem::path{sourcePath}.filename().string() + "." + hex + ".spv");
+    }
+
+    bool ShaderManager::readCache(const std::filesystem::path &path, std::vector<uint32_t> &spirv) const
+    {
+        std::ifstream file{path, std::ios::ate | std::ios::binary};
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        const size_t size = static_cast<size_t>(file.tellg());
+        if (size == 0 || size % sizeof(uint32_t) != 0)
+        {
+            return false;
+        }
+        spirv.resize(size / sizeof(uint32_t));
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(spirv.data()), static_cast<std::streamsize>(size));
+        return file && spirv[0] == SPIRV_MAGIC;
+    }
+
+    void ShaderManager::writeCache(const std::filesystem::path &path, const std::vector<uint32_t> &spirv) const
+    {
+        std::error_code error;
+        std::filesystem::create_directories(cacheDirectory, error);
+
+        // Same write-then-rename as the pipeline cache, readers never see half a file
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+        {
+            std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+            file.write(reinterpret_cast<const char *>(spirv.data()), static_cast<std::streamsize>(spirv.size() * sizeof(uint32_t)));
+            if (!file)
+            {
+                std::cerr << "shader cache: failed to write " << tempPath.string() << std::endl;
+                return;
+            }
+        }
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+        {
+            std::cerr << "shader cache: failed to replace " << path.string() << ": " << error.message() << std::endl;
+        }
+    }
+
+    std::vector<uint32_t> ShaderManager::compile(const std::string &sourcePath, const std::string &source, const std::string &preamble)
+    {
+        const EShLanguage stage = getStage(sourcePath);
+        const EShMessages messages = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules);
+
+        glslang::TShader shader{stage};
+        const char *strings[] = {source.c_str()};
+        const int lengths[] = {static_cast<int>(source.size())};
+        const char *names[] = {sourcePath.c_str()};
+        shader.setStringsWithLengthsAndNames(strings, lengths, names, 1);
+        shader.setPreamble(preamble.c_str());
+        shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 100);
+        shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
+        shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_0);
+
+        if (!shader.parse(GetDefaultResources(), 100, false, messages))
+        {
+            throw std::runtime_error("failed to compile shader " + sourcePath + ":\n" + shader.getInfoLog());
+        }
+
+        glslang::TProgram program;
+        program.addShader(&shader);
+        if (!program.link(messages))
+        {
+            throw std::runtime_error("failed to link shader " + sourcePath + ":\n" + program.getInfoLog());
+        }
+
+        std::vector<uint32_t> spirv;
+        glslang::GlslangToSpv(*program.getIntermediate(stage), spirv);
+        return spirv;
+    }
+
+    std::vector<uint32_t> ShaderManager::getSpirv(const std::string &sourcePath, const std::vector<ShaderDefine> &defines)
+    {
+        const std::vector<char> sourceBytes = Pipeline::readFile(sourcePath);
+        const std::string source{sourceBytes.begin(), sourceBytes.end()};
+        const std::string preamble = buildPreamble(defines);
+        const uint64_t key = hashKey(source, preamble);
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            auto it = memoryCache.find(key);
+            if (it != memoryCache.end())
+            {
+                stats.memoryHits++;
+                return it->second;
+            }
+        }
+
+        const std::filesystem::path cachePath = getCachePath(sourcePath, key);
+        std::vector<uint32_t> spirv;
+        const bool fromDisk = readCache(cachePath, spirv);
+        double compileMicroseconds = 0.0;
+        if (!fromDisk)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            spirv = compile(sourcePath, source, preamble);
+            const auto end = std::chrono::high_resolution_clock::now();
+            compileMicroseconds = std::chrono::duration<double, std::micro>(end - start).count();
+            writeCache(cachePath, spirv);
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        if (fromDisk)
+        {
+            stats.diskHits++;
+        }
+        else
+        {
+            stats.compiled++;
+            stats.compileMicroseconds += compileMicroseconds;
+        }
+        memoryCache.emplace(key, spirv);
+        return spirv;
+    }
+
+    ShaderManager::Stats ShaderManager::getStats() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return stats;
+    }
+}
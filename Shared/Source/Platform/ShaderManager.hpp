@@ -0,0 +1,67 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // A preprocessor define for one shader permutation, compiled in as "#define name value"
+    struct ShaderDefine
+    {
+        std::string name;
+        std::string value = "1";
+    };
+
+    // Compiles GLSL to SPIR-V at runtime through glslang.
+    //
+    // The stage comes from the file extension (.vert, .frag, .comp). Results are cached in memory
+    // and on disk, keyed by a hash of the source text and the defines, so an unchanged shader is
+    // only compiled once per permutation and later launches just read the .spv back. Editing the
+    // source changes the hash, the stale files are simply never read again.
+    //
+    // Thread safe, compilation itself runs outside the lock.
+    class ShaderManager
+    {
+    public:
+        static constexpr const char *DEFAULT_CACHE_DIRECTORY = "ShaderCache";
+
+        struct Stats
+        {
+            uint32_t memoryHits = 0;
+            uint32_t diskHits = 0;
+            uint32_t compiled = 0;
+            double compileMicroseconds = 0.0;
+        };
+
+        explicit ShaderManager(std::filesystem::path cacheDirectory = DEFAULT_CACHE_DIRECTORY);
+        ~ShaderManager();
+
+        ShaderManager(const ShaderManager &) = delete;
+        ShaderManager &operator=(const ShaderManager &) = delete;
+
+        // Throws std::runtime_error with the glslang log when the shader does not compile
+        std::vector<uint32_t> getSpirv(const std::string &sourcePath, const std::vector<ShaderDefine> &defines = {});
+
+        Stats getStats() const;
+
+    private:
+        static uint64_t hashKey(const std::string &source, const std::string &preamble);
+        static std::string buildPreamble(const std::vector<ShaderDefine> &defines);
+        static std::vector<uint32_t> compile(const std::string &sourcePath, const std::string &source, const std::string &preamble);
+
+        std::filesystem::path getCachePath(const std::string &sourcePath, uint64_t key) const;
+        bool readCache(const std::filesystem::path &path, std::vector<uint32_t> &spirv) const;
+        void writeCache(const std::filesystem::path &path, const std::vector<uint32_t> &spirv) const;
+
+        std::filesystem::path cacheDirectory;
+
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> memoryCache;
+        Stats stats{};
+    };
+}
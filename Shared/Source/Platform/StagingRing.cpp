@@ -0,0 +1,69 @@
+#include "StagingRing.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace VoxelEngine
+{
+    StagingRing::StagingRing(Device &device, VkDeviceSize capacity) : capacity{capacity}
+    {
+        buffer = std::make_unique<Buffer>(
+            device,
+            capacity,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+        if (buffer->map() != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to map staging ring!");
+        }
+        mapped = static_cast<unsigned char *>(buffer->getMappedMemory());
+    }
+
+    bool StagingRing::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, Allocation &allocation)
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+        if (size > capacity)
+        {
+            return false;
+        }
+
+        if (head == tail)
+        {
+            // Nothing in use, restart at the beginning so the whole capacity is contiguous again
+            head = tail = (head + capacity - 1) / capacity * capacity;
+        }
+
+        uint64_t start = head;
+        VkDeviceSize offset = (start % capacity + alignment - 1) & ~(alignment - 1);
+        if (offset + size > capacity)
+        {
+            // Skip the tail end of the ring, it is released together with this allocation
+            start += capacity - start % capacity;
+            offset = 0;
+        }
+        else
+        {
+            start += offset - start % capacity;
+        }
+
+        const uint64_t end = start + size;
+        if (end - tail > capacity)
+        {
+            return false;
+        }
+
+        head = end;
+        allocation.offset = offset;
+        allocation.data = mapped + offset;
+        return true;
+    }
+
+    void StagingRing::release(uint64_t position)
+    {
+        assert(position >= tail && position <= head && "Released position is outside the ring");
+        tail = position;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+
+namespace VoxelEngine
+{
+    // Persistently mapped host-visible ring for staging data.
+    //
+    // Allocations are carved from the head, wrapping to the start when a range does not fit before
+    // the end. Space is handed back in allocation order with release(position): the owner records
+    // getHead() when it submits the copies that read the data and releases it once the submission's
+    // fence signals. Positions are monotonic byte counts, so position - tail is the space in use.
+    class StagingRing
+    {
+    public:
+        struct Allocation
+        {
+            VkDeviceSize offset = 0;
+            void *data = nullptr;
+        };
+
+        StagingRing(Device &device, VkDeviceSize capacity);
+
+        StagingRing(const StagingRing &) = delete;
+        StagingRing &operator=(const StagingRing &) = delete;
+
+        // Returns false and leaves the ring untouched when the range does not fit right now
+        bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, Allocation &allocation);
+        // Frees everything allocated before position, which must come from getHead()
+        void release(uint64_t position);
+
+        uint64_t getHead() const { return head; }
+        VkBuffer getBuffer() const { return buffer->getBuffer(); }
+        VkDeviceSize getCapacity() const { return capacity; }
+        VkDeviceSize getUsed() const { return head - tail; }
+
+    private:
+        VkDeviceSize capacity;
+        std::unique_ptr<Buffer> buffer;
+        unsigned char *mapped = nullptr;
+
+        uint64_t head = 0;
+        uint64_t tail = 0;
+    };
+}
@@ -1,6 +1,7 @@
 #include "SwapChain.hpp"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -11,16 +12,20 @@
 
 namespace VoxelEngine {
 
-SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent)
-    : device{deviceRef}, windowExtent{extent} {
+SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent, const SwapChainConfig &config)
+    : config{config}, device{deviceRef}, windowExtent{extent} {
   init();
 }
 
-SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent, std::shared_ptr<SwapChain> previous)
-    : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous} {
+SwapChain::SwapChain(
+    Device &deviceRef,
+    VkExtent2D extent,
+    std::shared_ptr<SwapChain> previous,
+    const SwapChainConfig &config)
+    : config{config}, device{deviceRef}, windowExtent{extent}, oldSwapChain{previous} {
   init();
 
-  // If we have a previous swap chain, we need to destroy it
+  // The Renderer keeps the previous swap chain until its frames are done, we only needed its handle
   if (oldSwapChain) {
     oldSwapChain = nullptr; // Prevent dangling pointer
   }
@@ -51,13 +56,14 @@ SwapChain::~SwapChain() {
   for (int i = 0; i < depthImages.size(); i++) {
     vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
     vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    device.freeMemory(depthImageMemorys[i]);
   }
 
   for (auto framebuffer : swapChainFramebuffers) {
     vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
   }
 
+  // Null when the next swap chain took it over
   vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
   // Cleanup synchronization objects before destroying the swap chain or exiting the application.
@@ -76,12 +82,6 @@ SwapChain::~SwapChain() {
       vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
   }
 
-  // Destroy all fences used to synchronize CPU-GPU frame processing.
-  // These fences correspond to frames in flight, so their count matches MAX_FRAMES_IN_FLIGHT.
-  for (size_t i = 0; i < inFlightFences.size(); i++) {
-      vkDestroyFence(device.device(), inFlightFences[i], nullptr);
-  }
-
   // Old combined cleanup loop destroying all sync objects by iterating MAX_FRAMES_IN_FLIGHT:
   //
   // for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
@@ -96,7 +96,7 @@ SwapChain::~SwapChain() {
   //    which is often larger than MAX_FRAMES_IN_FLIGHT. Destroying only MAX_FRAMES_IN_FLIGHT of them
   //    causes resource leaks and potential validation errors.
   //
-  // 2. imageAvailableSemaphores and inFlightFences are sized by MAX_FRAMES_IN_FLIGHT (frames in flight),
+  // 2. imageAvailableSemaphores and the old inFlightFences are sized by MAX_FRAMES_IN_FLIGHT (frames in flight),
   //    so iterating up to MAX_FRAMES_IN_FLIGHT is correct for those, but not for renderFinishedSemaphores.
   //
   // 3. Mixing destruction of sync objects with different lifetimes and counts in one loop
@@ -106,36 +106,24 @@ SwapChain::~SwapChain() {
   // is destroyed exactly once without accessing invalid memory.
 }
 
-VkResult SwapChain::acquireNextImage(uint32_t *imageIndex) {
-  vkWaitForFences(
-      device.device(),
-      1,
-      &inFlightFences[currentFrame],
-      VK_TRUE,
-      std::numeric_limits<uint64_t>::max());
-
+VkResult SwapChain::acquireNextImage(uint32_t frameIndex, uint32_t *imageIndex) {
   VkResult result = vkAcquireNextImageKHR(
       device.device(),
       swapChain,
       std::numeric_limits<uint64_t>::max(),
-      imageAvailableSemaphores[currentFrame],  // must be a not signaled semaphore
+      imageAvailableSemaphores[frameIndex],  // must be a not signaled semaphore
       VK_NULL_HANDLE,
       imageIndex);
 
   return result;
 }
 
-VkResult SwapChain::submitCommandBuffers(
-    const VkCommandBuffer *buffers, uint32_t *imageIndex) {
-  if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-    vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-  }
-  imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
-
+void SwapChain::submitCommandBuffers(
+    const VkCommandBuffer *buffers, uint32_t *imageIndex, uint32_t frameIndex, FrameTimeline &timeline) {
   VkSubmitInfo submitInfo = {};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-  VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
+  VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[frameIndex]};
   VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
   submitInfo.waitSemaphoreCount = 1;
   submitInfo.pWaitSemaphores = waitSemaphores;
@@ -144,7 +132,7 @@ VkResult SwapChain::submitCommandBuffers(
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = buffers;
 
-  // Using `currentFrame` here would be incorrect because `renderFinishedSemaphores`
+  // Using `frameIndex` here would be incorrect because `renderFinishedSemaphores`
   // must be tied to the specific swapchain image being rendered, not the CPU frame index.
   // Each swapchain image can be acquired and presented out of order or multiple times
   // across different frames, so associating the semaphore by image index ensures
@@ -156,17 +144,15 @@ VkResult SwapChain::submitCommandBuffers(
   submitInfo.signalSemaphoreCount = 1;
   submitInfo.pSignalSemaphores = signalSemaphores;
 
-  vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-  if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-      VK_SUCCESS) {
-    throw std::runtime_error("failed to submit draw command buffer!");
-  }
+  timeline.submit(submitInfo);
+}
 
+VkResult SwapChain::presentImage(uint32_t *imageIndex) {
   VkPresentInfoKHR presentInfo = {};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
   presentInfo.waitSemaphoreCount = 1;
-  presentInfo.pWaitSemaphores = signalSemaphores;
+  presentInfo.pWaitSemaphores = &renderFinishedSemaphores[*imageIndex];
 
   VkSwapchainKHR swapChains[] = {swapChain};
   presentInfo.swapchainCount = 1;
@@ -174,21 +160,20 @@ VkResult SwapChain::submitCommandBuffers(
 
   presentInfo.pImageIndices = imageIndex;
 
-  auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
-
-  currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
-
-  return result;
+  return vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 }
 
 void SwapChain::createSwapChain() {
   SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
   VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-  VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+  presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
   VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
   uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+  if (config.imageCount > 0) {
+    imageCount = std::max(config.imageCount, swapChainSupport.capabilities.minImageCount);
+  }
   if (swapChainSupport.capabilities.maxImageCount > 0 &&
       imageCount > swapChainSupport.capabilities.maxImageCount) {
     imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -264,11 +249,21 @@ void SwapChain::createImageViews() {
 }
 
 void SwapChain::createRenderPass() {
+  // Take over the previous render pass so pipelines created against it stay valid. Frames still
+  // using the old framebuffers are fine with that, the render pass now lives as long as we do
+  if (oldSwapChain != nullptr && oldSwapChain->swapChainImageFormat == swapChainImageFormat &&
+      oldSwapChain->swapChainDepthFormat == findDepthFormat()) {
+    renderPass = oldSwapChain->renderPass;
+    oldSwapChain->renderPass = VK_NULL_HANDLE;
+    return;
+  }
+
   VkAttachmentDescription depthAttachment{};
   depthAttachment.format = findDepthFormat();
   depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
   depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  // Kept for the depth pyramid that culls the next frame
+  depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
   depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -367,7 +362,7 @@ void SwapChain::createDepthResources() {
     imageInfo.format = depthFormat;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
     imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     imageInfo.flags = 0;
@@ -402,32 +397,24 @@ void SwapChain::createSyncObjects() {
   // This prevents semaphore reuse conflicts, since swapchain images can be acquired,
   // rendered, and presented independently and possibly out of order.
   //
-  // This is different from imageAvailableSemaphores and inFlightFences, which are sized by
+  // This is different from imageAvailableSemaphores, which are sized by
   // MAX_FRAMES_IN_FLIGHT because they synchronize CPU frames in flight (e.g., triple buffering).
   // Those are tied to the number of frames the CPU can prepare concurrently, not the swapchain images.
   //
   // Using one semaphore per swapchain image ensures synchronization correctness and avoids
   // validation errors related to semaphore reuse while the GPU is still using an image.
   renderFinishedSemaphores.resize(imageCount());
-  inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-  imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
   VkSemaphoreCreateInfo semaphoreInfo = {};
   semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-  VkFenceCreateInfo fenceInfo = {};
-  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-  fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
   // Create synchronization objects for each frame in flight:
 
-  // imageAvailableSemaphores and inFlightFences are created per frame in flight (MAX_FRAMES_IN_FLIGHT).
-  // These synchronize CPU work and GPU rendering at the frame level:
-  // - imageAvailableSemaphores signal when an image is ready for rendering.
-  // - inFlightFences ensure that the CPU waits for the GPU to finish processing a frame before reusing resources.
+  // imageAvailableSemaphores are created per frame in flight (MAX_FRAMES_IN_FLIGHT) and signal when
+  // an image is ready for rendering. Waiting for the GPU to finish a frame before its resources are
+  // reused is the FrameTimeline's job, the Renderer owns it.
   for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-      vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+    if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS) {
       throw std::runtime_error("failed to create sync objects!");
     }
   }
@@ -481,23 +468,32 @@ VkSurfaceFormatKHR SwapChain::chooseSwapSurfaceFormat(
 VkPresentModeKHR SwapChain::chooseSwapPresentMode(
   const std::vector<VkPresentModeKHR> &availablePresentModes) {
   for (const auto &availablePresentMode : availablePresentModes) {
-    if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-      std::cout << "Present mode: Mailbox" << std::endl;
+    if (availablePresentMode == config.presentMode) {
+      std::cout << "Present mode: " << getPresentModeName(availablePresentMode) << std::endl;
       return availablePresentMode;
     }
   }
 
-  // for (const auto &availablePresentMode : availablePresentModes) {
-  //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-  //     std::cout << "Present mode: Immediate" << std::endl;
-  //     return availablePresentMode;
-  //   }
-  // }
-
-  std::cout << "Present mode: V-Sync" << std::endl;
+  std::cout << "Present mode: " << getPresentModeName(config.presentMode)
+            << " unavailable, using " << getPresentModeName(VK_PRESENT_MODE_FIFO_KHR) << std::endl;
   return VK_PRESENT_MODE_FIFO_KHR;
 }
 
+const char *SwapChain::getPresentModeName(VkPresentModeKHR presentMode) {
+  switch (presentMode) {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+      return "Immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+      return "Mailbox";
+    case VK_PRESENT_MODE_FIFO_KHR:
+      return "V-Sync";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+      return "V-Sync (relaxed)";
+    default:
+      return "Unknown";
+  }
+}
+
 VkExtent2D SwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities) {
   if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
     return capabilities.currentExtent;
@@ -518,7 +514,7 @@ VkFormat SwapChain::findDepthFormat() {
   return device.findSupportedFormat(
       {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
       VK_IMAGE_TILING_OPTIMAL,
-      VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+      VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
 }
 
 }
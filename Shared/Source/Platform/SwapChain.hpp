@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Device.hpp"
+#include "FrameTimeline.hpp"
 
 // vulkan headers
 #include <vulkan/vulkan.h>
@@ -12,12 +13,26 @@
 
 namespace VoxelEngine {
 
+// What the Renderer asks for, the surface may not support all of it
+struct SwapChainConfig {
+  // Falls back to FIFO, the only mode every device has
+  VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+  // 0 picks minImageCount + 1, anything else is clamped to the surface limits
+  uint32_t imageCount = 0;
+};
+
 class SwapChain {
  public:
-  static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-  SwapChain(Device &deviceRef, VkExtent2D windowExtent);
-  SwapChain(Device &deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> previous);
+  // Per-frame resources are sized for the maximum, the Renderer picks how many are used
+  static constexpr int MAX_FRAMES_IN_FLIGHT = 4;
+  static constexpr int DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+  SwapChain(Device &deviceRef, VkExtent2D windowExtent, const SwapChainConfig &config = {});
+  SwapChain(
+      Device &deviceRef,
+      VkExtent2D windowExtent,
+      std::shared_ptr<SwapChain> previous,
+      const SwapChainConfig &config = {});
   ~SwapChain();
 
   SwapChain(const SwapChain &) = delete;
@@ -26,9 +41,14 @@ class SwapChain {
   VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
   VkRenderPass getRenderPass() { return renderPass; }
   VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+  VkImage getDepthImage(int index) { return depthImages[index]; }
+  VkImageView getDepthImageView(int index) { return depthImageViews[index]; }
+  VkFormat getDepthFormat() { return swapChainDepthFormat; }
   size_t imageCount() { return swapChainImages.size(); }
   VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
   VkExtent2D getSwapChainExtent() { return swapChainExtent; }
+  VkPresentModeKHR getPresentMode() { return presentMode; }
+  static const char *getPresentModeName(VkPresentModeKHR presentMode);
   uint32_t width() { return swapChainExtent.width; }
   uint32_t height() { return swapChainExtent.height; }
 
@@ -37,8 +57,12 @@ class SwapChain {
   }
   VkFormat findDepthFormat();
 
-  VkResult acquireNextImage(uint32_t *imageIndex);
-  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  // The caller must have waited for frameIndex's previous submission, its semaphore is reused
+  VkResult acquireNextImage(uint32_t frameIndex, uint32_t *imageIndex);
+  void submitCommandBuffers(
+      const VkCommandBuffer *buffers, uint32_t *imageIndex, uint32_t frameIndex, FrameTimeline &timeline);
+  // Waits on the semaphore signalled by the image's submitCommandBuffers()
+  VkResult presentImage(uint32_t *imageIndex);
 
   bool compareSwapFormats(const SwapChain &swapChain) const {
     return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -61,6 +85,8 @@ class SwapChain {
       const std::vector<VkPresentModeKHR> &availablePresentModes);
   VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
 
+  SwapChainConfig config;
+  VkPresentModeKHR presentMode;
   VkFormat swapChainImageFormat;
   VkFormat swapChainDepthFormat;
   VkExtent2D swapChainExtent;
@@ -69,7 +95,7 @@ class SwapChain {
   VkRenderPass renderPass;
 
   std::vector<VkImage> depthImages;
-  std::vector<VkDeviceMemory> depthImageMemorys;
+  std::vector<MemoryAllocation> depthImageMemorys;
   std::vector<VkImageView> depthImageViews;
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
@@ -82,9 +108,6 @@ class SwapChain {
 
   std::vector<VkSemaphore> imageAvailableSemaphores;
   std::vector<VkSemaphore> renderFinishedSemaphores;
-  std::vector<VkFence> inFlightFences;
-  std::vector<VkFence> imagesInFlight;
-  size_t currentFrame = 0;
 };
 
 }
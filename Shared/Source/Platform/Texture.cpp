@@ -1,6 +1,5 @@
 #include "Texture.hpp"
 #include "Device.hpp"
-#include "Buffer.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -10,7 +9,7 @@
 
 namespace VoxelEngine
 {
-    Texture::Texture(Device &device, const std::string &filepath) : device{device}
+    Texture::Texture(Device &device, UploadManager &uploadManager, const std::string &filepath) : device{device}
     {
         int channels;
         int m_BytesPerPixel;
@@ -19,16 +18,6 @@ namespace VoxelEngine
 
         mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
 
-        Buffer stagingBuffer{
-            device,
-            4,
-            static_cast<uint32_t>(width * height),
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer(data);
-
         imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
 
         VkImageCreateInfo imageInfo = {};
@@ -48,7 +37,9 @@ namespace VoxelEngine
 
         transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-        device.copyBufferToImage(stagingBuffer.getBuffer(), image, static_cast<unsigned int>(width), static_cast<unsigned int>(height), 1);
+        // Level 0 goes through the upload staging ring, the blits below need it in place
+        const VkDeviceSize imageSize = static_cast<VkDeviceSize>(width) * height * 4;
+        uploadManager.wait(uploadManager.uploadImage(data, imageSize, image, static_cast<uint32_t>(width), static_cast<uint32_t>(height)));
 
         generateMipmaps();
         imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -90,10 +81,14 @@ namespace VoxelEngine
 
     Texture::~Texture()
     {
-        vkDestroyImage(device.device(), image, nullptr);
-        vkFreeMemory(device.device(), imageMemory, nullptr);
-        vkDestroyImageView(device.device(), imageView, nullptr);
-        vkDestroySampler(device.device(), sampler, nullptr);
+        // Frames still in flight may sample it
+        device.deletionQueue().push([&device = device, image = image, imageMemory = imageMemory, imageView = imageView, sampler = sampler]() mutable
+                                    {
+                                        vkDestroyImageView(device.device(), imageView, nullptr);
+                                        vkDestroyImage(device.device(), image, nullptr);
+                                        device.freeMemory(imageMemory);
+                                        vkDestroySampler(device.device(), sampler, nullptr);
+                                    });
     }
 
     void Texture::transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout)
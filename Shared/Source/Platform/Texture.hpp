@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Device.hpp"
+#include "UploadManager.hpp"
 
 #include <string.h>
 
@@ -9,7 +10,7 @@ namespace VoxelEngine
     class Texture
     {
     public:
-        Texture(Device &device, const std::string &filepath);
+        Texture(Device &device, UploadManager &uploadManager, const std::string &filepath);
         ~Texture();
 
         Texture(const Texture &) = delete;
@@ -29,7 +30,7 @@ namespace VoxelEngine
 
         Device &device;
         VkImage image;
-        VkDeviceMemory imageMemory;
+        MemoryAllocation imageMemory;
         VkImageView imageView;
         VkSampler sampler;
         VkFormat imageFormat;
@@ -0,0 +1,247 @@
+#include "UploadManager.hpp"
+
+// std
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace VoxelEngine
+{
+    UploadManager::UploadManager(Device &device, VkDeviceSize stagingCapacity)
+        : device{device}, stagingRing{device, stagingCapacity}
+    {
+        createCommandPool();
+    }
+
+    UploadManager::~UploadManager()
+    {
+        waitIdle();
+
+        for (auto &batch : freeBatches)
+        {
+            vkDestroyFence(device.device(), batch->fence, nullptr);
+        }
+        vkDestroyCommandPool(device.device(), commandPool, nullptr);
+    }
+
+    void UploadManager::createCommandPool()
+    {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = device.transferQueueFamily();
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+    }
+
+    std::unique_ptr<UploadManager::Batch> UploadManager::acquireBatch()
+    {
+        if (!freeBatches.empty())
+        {
+            auto batch = std::move(freeBatches.back());
+            freeBatches.pop_back();
+            vkResetFences(device.device(), 1, &batch->fence);
+            vkResetCommandBuffer(batch->commandBuffer, 0);
+            return batch;
+        }
+
+        auto batch = std::make_unique<Batch>();
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device.device(), &allocInfo, &batch->commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate upload command buffer!");
+        }
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device.device(), &fenceInfo, nullptr, &batch->fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload fence!");
+        }
+        return batch;
+    }
+
+    void UploadManager::beginRecording()
+    {
+        recording = acquireBatch();
+        recording->ticket = nextTicket;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(recording->commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording upload command buffer!");
+        }
+    }
+
+    bool UploadManager::allocateStaging(VkDeviceSize size, StagingRing::Allocation &allocation)
+    {
+        if (size > stagingRing.getCapacity())
+        {
+            return false;
+        }
+
+        // Out of space: wait for the oldest batches, and if the ring is only held by the batch
+        // being recorded, submit it first. The caller records into a fresh batch afterwards.
+        while (!stagingRing.tryAllocate(size, STAGING_ALIGNMENT, allocation))
+        {
+            if (inFlight.empty())
+            {
+                flush();
+                beginRecording();
+            }
+            vkWaitForFences(device.device(), 1, &inFlight.front()->fence, VK_TRUE, UINT64_MAX);
+            retireBatch();
+        }
+        return true;
+    }
+
+    void UploadManager::stage(const void *data, VkDeviceSize size, VkBuffer &srcBuffer, VkDeviceSize &srcOffset)
+    {
+        if (!recording)
+        {
+            beginRecording();
+        }
+
+        StagingRing::Allocation allocation{};
+        if (allocateStaging(size, allocation))
+        {
+            std::memcpy(allocation.data, data, static_cast<size_t>(size));
+            srcBuffer = stagingRing.getBuffer();
+            srcOffset = allocation.offset;
+            recording->stagingEnd = stagingRing.getHead();
+            return;
+        }
+
+        auto stagingBuffer = std::make_unique<Buffer>(
+            device,
+            size,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        stagingBuffer->map();
+        stagingBuffer->writeToBuffer(const_cast<void *>(data), size);
+        stagingBuffer->unmap();
+
+        srcBuffer = stagingBuffer->getBuffer();
+        srcOffset = 0;
+        recording->stagingBuffers.push_back(std::move(stagingBuffer));
+    }
+
+    UploadManager::Ticket UploadManager::uploadBuffer(const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+    {
+        assert(size > 0 && "Cannot upload an empty range");
+
+        VkBuffer srcBuffer;
+        VkBufferCopy copyRegion{};
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        stage(data, size, srcBuffer, copyRegion.srcOffset);
+
+        vkCmdCopyBuffer(recording->commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+        return recording->ticket;
+    }
+
+    UploadManager::Ticket UploadManager::uploadImage(const void *data, VkDeviceSize size, VkImage dstImage, uint32_t width, uint32_t height)
+    {
+        assert(size > 0 && "Cannot upload an empty image");
+
+        VkBuffer srcBuffer;
+        VkBufferImageCopy region{};
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {width, height, 1};
+        stage(data, size, srcBuffer, region.bufferOffset);
+
+        vkCmdCopyBufferToImage(recording->commandBuffer, srcBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        return recording->ticket;
+    }
+
+    UploadManager::Ticket UploadManager::flush()
+    {
+        if (!recording)
+        {
+            return nextTicket - 1;
+        }
+
+        if (vkEndCommandBuffer(recording->commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record upload command buffer!");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &recording->commandBuffer;
+
+        if (vkQueueSubmit(device.transferQueue(), 1, &submitInfo, recording->fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit upload command buffer!");
+        }
+
+        inFlight.push_back(std::move(recording));
+        return nextTicket++;
+    }
+
+    void UploadManager::poll()
+    {
+        // Tickets complete in order, so stop at the first batch that is still running
+        while (!inFlight.empty() && vkGetFenceStatus(device.device(), inFlight.front()->fence) == VK_SUCCESS)
+        {
+            retireBatch();
+        }
+    }
+
+    void UploadManager::retireBatch()
+    {
+        auto batch = std::move(inFlight.front());
+        inFlight.pop_front();
+
+        completedTicket = batch->ticket;
+        if (batch->stagingEnd > 0)
+        {
+            stagingRing.release(batch->stagingEnd);
+        }
+        batch->stagingEnd = 0;
+        batch->stagingBuffers.clear();
+        freeBatches.push_back(std::move(batch));
+    }
+
+    void UploadManager::wait(Ticket ticket)
+    {
+        if (recording && ticket >= recording->ticket)
+        {
+            flush();
+        }
+
+        while (!isComplete(ticket) && !inFlight.empty())
+        {
+            vkWaitForFences(device.device(), 1, &inFlight.front()->fence, VK_TRUE, UINT64_MAX);
+            retireBatch();
+        }
+    }
+
+    void UploadManager::waitIdle()
+    {
+        flush();
+        for (auto &batch : inFlight)
+        {
+            vkWaitForFences(device.device(), 1, &batch->fence, VK_TRUE, UINT64_MAX);
+        }
+        poll();
+    }
+}
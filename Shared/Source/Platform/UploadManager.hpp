@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "StagingRing.hpp"
+
+// std
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Asynchronous buffer and image uploads on the transfer queue.
+    //
+    // Uploads are recorded into the current batch and go to the GPU together on flush(), one
+    // submit and one fence per batch, so nothing waits for the queue to go idle. Every upload
+    // returns the ticket of its batch; poll() retires finished batches and isComplete() tells
+    // whether the destination buffer is safe to read from.
+    //
+    // Staging data lives in a StagingRing that is recycled as batches retire. Only an upload larger
+    // than the whole ring gets a staging buffer of its own.
+    //
+    // Not thread safe, use it from the render thread.
+    class UploadManager
+    {
+    public:
+        using Ticket = uint64_t;
+        // Never handed out, isComplete() is always true for it
+        static constexpr Ticket COMPLETED_TICKET = 0;
+        static constexpr VkDeviceSize DEFAULT_STAGING_CAPACITY = 32 * 1024 * 1024;
+        static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+        UploadManager(Device &device, VkDeviceSize stagingCapacity = DEFAULT_STAGING_CAPACITY);
+        ~UploadManager();
+
+        UploadManager(const UploadManager &) = delete;
+        UploadManager &operator=(const UploadManager &) = delete;
+
+        // Copies data into staging memory right away, the copy into dstBuffer runs after flush()
+        Ticket uploadBuffer(const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+        // Same for mip level 0 of dstImage, which must be in TRANSFER_DST_OPTIMAL when the batch runs
+        Ticket uploadImage(const void *data, VkDeviceSize size, VkImage dstImage, uint32_t width, uint32_t height);
+
+        // Submits the current batch if it has any uploads, returns the last submitted ticket
+        Ticket flush();
+        // Retires finished batches and frees their staging memory, call once per frame
+        void poll();
+        // Flushes if needed and blocks until the batch of ticket has finished
+        void wait(Ticket ticket);
+        // Flushes and blocks until every upload so far has finished
+        void waitIdle();
+
+        bool isComplete(Ticket ticket) const { return ticket <= completedTicket; }
+        Ticket getCompletedTicket() const { return completedTicket; }
+        size_t getBatchesInFlight() const { return inFlight.size(); }
+        const StagingRing &getStagingRing() const { return stagingRing; }
+
+    private:
+        struct Batch
+        {
+            Ticket ticket = COMPLETED_TICKET;
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+            // Staging ring head after the batch's last allocation
+            uint64_t stagingEnd = 0;
+            // Oversized uploads that did not fit in the ring
+            std::vector<std::unique_ptr<Buffer>> stagingBuffers;
+        };
+
+        void createCommandPool();
+        std::unique_ptr<Batch> acquireBatch();
+        void beginRecording();
+        bool allocateStaging(VkDeviceSize size, StagingRing::Allocation &allocation);
+        // Copies data into the ring, or an oversized staging buffer, for the batch being recorded
+        void stage(const void *data, VkDeviceSize size, VkBuffer &srcBuffer, VkDeviceSize &srcOffset);
+        void retireBatch();
+
+        Device &device;
+        VkCommandPool commandPool;
+        StagingRing stagingRing;
+
+        std::unique_ptr<Batch> recording;
+        // Submitted batches in ticket order, they finish in that order too
+        std::deque<std::unique_ptr<Batch>> inFlight;
+        std::vector<std::unique_ptr<Batch>> freeBatches;
+
+        Ticket nextTicket = 1;
+        Ticket completedTicket = COMPLETED_TICKET;
+    };
+}
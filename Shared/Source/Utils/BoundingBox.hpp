@@ -0,0 +1,59 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <limits>
+
+namespace VoxelEngine
+{
+    // Axis-aligned bounding box. Default constructed it is empty and grows with every point.
+    struct BoundingBox
+    {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+        bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+        glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+        glm::vec3 getExtent() const { return (max - min) * 0.5f; }
+
+        // Half the surface area, enough to compare costs in the BVH
+        float getPerimeter() const
+        {
+            const glm::vec3 size = max - min;
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
+
+        void expand(const glm::vec3 &point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        bool contains(const BoundingBox &other) const
+        {
+            return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+                   max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+        }
+
+        static BoundingBox merge(const BoundingBox &a, const BoundingBox &b)
+        {
+            return BoundingBox{glm::min(a.min, b.min), glm::max(a.max, b.max)};
+        }
+
+        // Box around this box after an affine transform (Arvo, Graphics Gems 1990)
+        BoundingBox transformed(const glm::mat4 &transform) const
+        {
+            const glm::vec3 center = glm::vec3{transform * glm::vec4{getCenter(), 1.f}};
+            const glm::vec3 extent = getExtent();
+            const glm::vec3 worldExtent{
+                glm::abs(transform[0][0]) * extent.x + glm::abs(transform[1][0]) * extent.y + glm::abs(transform[2][0]) * extent.z,
+                glm::abs(transform[0][1]) * extent.x + glm::abs(transform[1][1]) * extent.y + glm::abs(transform[2][1]) * extent.z,
+                glm::abs(transform[0][2]) * extent.x + glm::abs(transform[1][2]) * extent.y + glm::abs(transform[2][2]) * extent.z};
+            return BoundingBox{center - worldExtent, center + worldExtent};
+        }
+    };
+}
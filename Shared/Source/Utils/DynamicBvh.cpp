@@ -0,0 +1,260 @@
+#include "DynamicBvh.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace VoxelEngine
+{
+    DynamicBvh::DynamicBvh(float margin) : margin{margin} {}
+
+    uint32_t DynamicBvh::allocateNode()
+    {
+        uint32_t node;
+        if (freeList != NULL_NODE)
+        {
+            node = freeList;
+            freeList = nodes[node].parent;
+        }
+        else
+        {
+            node = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+        }
+
+        nodes[node] = Node{};
+        nodes[node].height = 0;
+        return node;
+    }
+
+    void DynamicBvh::freeNode(uint32_t node)
+    {
+        nodes[node].parent = freeList;
+        nodes[node].height = -1;
+        freeList = node;
+    }
+
+    uint32_t DynamicBvh::createProxy(const BoundingBox &box, uint32_t userData)
+    {
+        const uint32_t proxy = allocateNode();
+        nodes[proxy].box = BoundingBox{box.min - glm::vec3{margin}, box.max + glm::vec3{margin}};
+        nodes[proxy].userData = userData;
+        insertLeaf(proxy);
+        proxyCount++;
+        return proxy;
+    }
+
+    void DynamicBvh::destroyProxy(uint32_t proxy)
+    {
+        assert(proxy < nodes.size() && nodes[proxy].isLeaf() && nodes[proxy].height == 0 && "Destroying an invalid proxy");
+        removeLeaf(proxy);
+        freeNode(proxy);
+        proxyCount--;
+    }
+
+    bool DynamicBvh::moveProxy(uint32_t proxy, const BoundingBox &box)
+    {
+        assert(proxy < nodes.size() && nodes[proxy].isLeaf() && nodes[proxy].height == 0 && "Moving an invalid proxy");
+        if (nodes[proxy].box.contains(box))
+        {
+            return false;
+        }
+
+        removeLeaf(proxy);
+        nodes[proxy].box = BoundingBox{box.min - glm::vec3{margin}, box.max + glm::vec3{margin}};
+        insertLeaf(proxy);
+        return true;
+    }
+
+    uint32_t DynamicBvh::findBestSibling(const BoundingBox &box) const
+    {
+        uint32_t index = root;
+        while (!nodes[index].isLeaf())
+        {
+            const uint32_t child1 = nodes[index].child1;
+            const uint32_t child2 = nodes[index].child2;
+
+            const float area = nodes[index].box.getPerimeter();
+            const float combinedArea = BoundingBox::merge(nodes[index].box, box).getPerimeter();
+
+            // Cost of making a new parent for this node and the leaf
+            const float cost = 2.f * combinedArea;
+            // Minimum cost of pushing the leaf further down, every ancestor grows by this much
+            const float inheritanceCost = 2.f * (combinedArea - area);
+
+            auto descendCost = [&](uint32_t child)
+            {
+                const float mergedArea = BoundingBox::merge(box, nodes[child].box).getPerimeter();
+                if (nodes[child].isLeaf())
+                {
+                    return mergedArea + inheritanceCost;
+                }
+                return mergedArea - nodes[child].box.getPerimeter() + inheritanceCost;
+            };
+            const float cost1 = descendCost(child1);
+            const float cost2 = descendCost(child2);
+
+            if (cost < cost1 && cost < cost2)
+            {
+                break;
+            }
+            index = cost1 < cost2 ? child1 : child2;
+        }
+        return index;
+    }
+
+    void DynamicBvh::insertLeaf(uint32_t leaf)
+    {
+        if (root == NULL_NODE)
+        {
+            root = leaf;
+            nodes[root].parent = NULL_NODE;
+            return;
+        }
+
+        const uint32_t sibling = findBestSibling(nodes[leaf].box);
+        const uint32_t oldParent = nodes[sibling].parent;
+        const uint32_t newParent = allocateNode();
+
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].box = BoundingBox::merge(nodes[leaf].box, nodes[sibling].box);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+
+        if (oldParent != NULL_NODE)
+        {
+            if (nodes[oldParent].child1 == sibling)
+            {
+                nodes[oldParent].child1 = newParent;
+            }
+            else
+            {
+                nodes[oldParent].child2 = newParent;
+            }
+        }
+        else
+        {
+            root = newParent;
+        }
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        refitAncestors(nodes[leaf].parent);
+    }
+
+    void DynamicBvh::removeLeaf(uint32_t leaf)
+    {
+        if (leaf == root)
+        {
+            root = NULL_NODE;
+            return;
+        }
+
+        const uint32_t parent = nodes[leaf].parent;
+        const uint32_t grandParent = nodes[parent].parent;
+        const uint32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        if (grandParent != NULL_NODE)
+        {
+            if (nodes[grandParent].child1 == parent)
+            {
+                nodes[grandParent].child1 = sibling;
+            }
+            else
+            {
+                nodes[grandParent].child2 = sibling;
+            }
+            nodes[sibling].parent = grandParent;
+            freeNode(parent);
+            refitAncestors(grandParent);
+        }
+        else
+        {
+            root = sibling;
+            nodes[sibling].parent = NULL_NODE;
+            freeNode(parent);
+        }
+    }
+
+    void DynamicBvh::refitAncestors(uint32_t node)
+    {
+        while (node != NULL_NODE)
+        {
+            node = balance(node);
+
+            const uint32_t child1 = nodes[node].child1;
+            const uint32_t child2 = nodes[node].child2;
+            nodes[node].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+            nodes[node].box = BoundingBox::merge(nodes[child1].box, nodes[child2].box);
+
+            node = nodes[node].parent;
+        }
+    }
+
+    // Rotates the taller grandchild up when the children differ in height by more than one,
+    // returns the node now at a's position
+    uint32_t DynamicBvh::balance(uint32_t a)
+    {
+        if (nodes[a].isLeaf() || nodes[a].height < 2)
+        {
+            return a;
+        }
+
+        const uint32_t b = nodes[a].child1;
+        const uint32_t c = nodes[a].child2;
+        const int difference = nodes[c].height - nodes[b].height;
+        if (difference >= -1 && difference <= 1)
+        {
+            return a;
+        }
+
+        // up is the taller child, stay is the other one; up takes a's place and a becomes its child
+        const bool rotateC = difference > 1;
+        const uint32_t up = rotateC ? c : b;
+        const uint32_t stay = rotateC ? b : c;
+        const uint32_t f = nodes[up].child1;
+        const uint32_t g = nodes[up].child2;
+
+        nodes[up].child1 = a;
+        nodes[up].parent = nodes[a].parent;
+        nodes[a].parent = up;
+
+        if (nodes[up].parent != NULL_NODE)
+        {
+            if (nodes[nodes[up].parent].child1 == a)
+            {
+                nodes[nodes[up].parent].child1 = up;
+            }
+            else
+            {
+                nodes[nodes[up].parent].child2 = up;
+            }
+        }
+        else
+        {
+            root = up;
+        }
+
+        // The taller grandchild stays with up, the shorter one moves under a in up's old slot
+        const uint32_t keep = nodes[f].height > nodes[g].height ? f : g;
+        const uint32_t move = keep == f ? g : f;
+
+        nodes[up].child2 = keep;
+        if (rotateC)
+        {
+            nodes[a].child2 = move;
+        }
+        else
+        {
+            nodes[a].child1 = move;
+        }
+        nodes[move].parent = a;
+
+        nodes[a].box = BoundingBox::merge(nodes[stay].box, nodes[move].box);
+        nodes[a].height = 1 + std::max(nodes[stay].height, nodes[move].height);
+        nodes[up].box = BoundingBox::merge(nodes[a].box, nodes[keep].box);
+        nodes[up].height = 1 + std::max(nodes[a].height, nodes[keep].height);
+        return up;
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "BoundingBox.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Dynamic bounding volume hierarchy of fat AABBs.
+    //
+    // Leaves store a box grown by a margin, so a proxy that moves a little stays where it is and
+    // only moves that leave the fat box cost a remove and reinsert. Inserting picks the sibling
+    // with the lowest surface area cost and the tree is rebalanced with AVL style rotations on
+    // the way up, so it stays shallow however proxies come and go.
+    // from: https://box2d.org/files/ErinCatto_DynamicBVH_GDC2019.pdf
+    class DynamicBvh
+    {
+    public:
+        static constexpr uint32_t NULL_NODE = UINT32_MAX;
+
+        enum class Visit
+        {
+            Skip,     // Nothing below is wanted
+            Descend,  // Test the children
+            TakeAll   // Everything below is wanted, no more tests
+        };
+
+        explicit DynamicBvh(float margin = 0.1f);
+
+        DynamicBvh(const DynamicBvh &) = delete;
+        DynamicBvh &operator=(const DynamicBvh &) = delete;
+
+        uint32_t createProxy(const BoundingBox &box, uint32_t userData);
+        void destroyProxy(uint32_t proxy);
+        // Returns true if the proxy had to be reinserted
+        bool moveProxy(uint32_t proxy, const BoundingBox &box);
+
+        uint32_t getUserData(uint32_t proxy) const { return nodes[proxy].userData; }
+        const BoundingBox &getFatBox(uint32_t proxy) const { return nodes[proxy].box; }
+        uint32_t getProxyCount() const { return proxyCount; }
+        int getHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+        // test(const BoundingBox &) -> Visit on every reached node, visit(userData) on every wanted leaf
+        template <typename Test, typename Callback>
+        void query(Test &&test, Callback &&visit) const;
+
+    private:
+        struct Node
+        {
+            BoundingBox box{};
+            // Next free node while on the free list
+            uint32_t parent = NULL_NODE;
+            uint32_t child1 = NULL_NODE;
+            uint32_t child2 = NULL_NODE;
+            // Leaves are 0, free nodes -1
+            int height = -1;
+            uint32_t userData = 0;
+
+            bool isLeaf() const { return child1 == NULL_NODE; }
+        };
+
+        uint32_t allocateNode();
+        void freeNode(uint32_t node);
+        void insertLeaf(uint32_t leaf);
+        void removeLeaf(uint32_t leaf);
+        uint32_t findBestSibling(const BoundingBox &box) const;
+        // Refits boxes and heights from node to the root, rotating where unbalanced
+        void refitAncestors(uint32_t node);
+        uint32_t balance(uint32_t node);
+        template <typename Callback>
+        void visitLeaves(uint32_t node, Callback &visit, std::vector<uint32_t> &stack) const;
+
+        float margin;
+        std::vector<Node> nodes;
+        uint32_t root = NULL_NODE;
+        uint32_t freeList = NULL_NODE;
+        uint32_t proxyCount = 0;
+
+        // Reused between queries so traversal does not allocate
+        mutable std::vector<uint32_t> queryStack;
+        mutable std::vector<uint32_t> subtreeStack;
+    };
+
+    template <typename Test, typename Callback>
+    void DynamicBvh::query(Test &&test, Callback &&visit) const
+    {
+        if (root == NULL_NODE)
+        {
+            return;
+        }
+
+        std::vector<uint32_t> &stack = queryStack;
+        stack.clear();
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            const uint32_t node = stack.back();
+            stack.pop_back();
+
+            const Visit result = test(nodes[node].box);
+            if (result == Visit::Skip)
+            {
+                continue;
+            }
+            if (result == Visit::TakeAll || nodes[node].isLeaf())
+            {
+                visitLeaves(node, visit, subtreeStack);
+                continue;
+            }
+            stack.push_back(nodes[node].child1);
+            stack.push_back(nodes[node].child2);
+        }
+    }
+
+    template <typename Callback>
+    void DynamicBvh::visitLeaves(uint32_t node, Callback &visit, std::vector<uint32_t> &stack) const
+    {
+        stack.clear();
+        stack.push_back(node);
+        while (!stack.empty())
+        {
+            const Node &current = nodes[stack.back()];
+            stack.pop_back();
+            if (current.isLeaf())
+            {
+                visit(current.userData);
+            }
+            else
+            {
+                stack.push_back(current.child1);
+                stack.push_back(current.child2);
+            }
+        }
+    }
+}
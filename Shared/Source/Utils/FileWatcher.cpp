@@ -0,0 +1,102 @@
+#include "FileWatcher.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace VoxelEngine
+{
+#ifdef __linux__
+    FileWatcher::FileWatcher()
+    {
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0)
+        {
+            throw std::runtime_error("failed to initialize inotify!");
+        }
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        close(inotifyFd);
+    }
+
+    void FileWatcher::watch(const std::string &path)
+    {
+        const std::filesystem::path absolute = std::filesystem::absolute(path).lexically_normal();
+        const std::filesystem::path directory = absolute.parent_path();
+
+        const int wd = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0)
+        {
+            throw std::runtime_error("failed to watch directory: " + directory.string());
+        }
+        // Adding the same directory twice returns the same descriptor
+        directories[wd] = directory;
+        files[absolute.string()] = path;
+    }
+
+    std::vector<std::string> FileWatcher::poll()
+    {
+        std::vector<std::string> changed;
+        alignas(inotify_event) char buffer[4096];
+        while (true)
+        {
+            const ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0)
+            {
+                break;
+            }
+
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                auto directory = directories.find(event->wd);
+                if (directory == directories.end() || event->len == 0)
+                {
+                    continue;
+                }
+                auto file = files.find((directory->second / event->name).string());
+                if (file != files.end() && std::find(changed.begin(), changed.end(), file->second) == changed.end())
+                {
+                    changed.push_back(file->second);
+                }
+            }
+        }
+        return changed;
+    }
+#else
+    FileWatcher::FileWatcher() = default;
+    FileWatcher::~FileWatcher() = default;
+
+    void FileWatcher::watch(const std::string &path)
+    {
+        std::error_code error;
+        files.push_back({path, std::filesystem::last_write_time(path, error)});
+    }
+
+    std::vector<std::string> FileWatcher::poll()
+    {
+        std::vector<std::string> changed;
+        for (auto &file : files)
+        {
+            std::error_code error;
+            const auto lastWrite = std::filesystem::last_write_time(file.path, error);
+            // A missing file is mid-save, look again next poll
+            if (!error && lastWrite != file.lastWrite)
+            {
+                file.lastWrite = lastWrite;
+                changed.push_back(file.path);
+            }
+        }
+        return changed;
+    }
+#endif
+}
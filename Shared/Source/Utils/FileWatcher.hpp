@@ -0,0 +1,45 @@
+#pragma once
+
+// std
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Reports files that were written since the last poll().
+    //
+    // On Linux it watches the parent directories through inotify rather than the files
+    // themselves, because editors often save by writing a new file and renaming it over the old
+    // one, which would silently end a watch on the old inode. Elsewhere it compares modification
+    // times on every poll(), fine for the handful of files it is meant for.
+    class FileWatcher
+    {
+    public:
+        FileWatcher();
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher &) = delete;
+        FileWatcher &operator=(const FileWatcher &) = delete;
+
+        void watch(const std::string &path);
+        // Never blocks, each changed path is reported once however many writes it saw
+        std::vector<std::string> poll();
+
+    private:
+#ifdef __linux__
+        int inotifyFd = -1;
+        // Watch descriptor to directory, and watched file names to the path given to watch()
+        std::unordered_map<int, std::filesystem::path> directories;
+        std::unordered_map<std::string, std::string> files;
+#else
+        struct WatchedFile
+        {
+            std::string path;
+            std::filesystem::file_time_type lastWrite;
+        };
+        std::vector<WatchedFile> files;
+#endif
+    };
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace VoxelEngine
+{
+    // Bounded lock-free multi-producer multi-consumer queue.
+    //
+    // Dmitry Vyukov's array queue: every cell carries a sequence number that tells producers and
+    // consumers whether it is free for the current lap, so each operation is a single CAS on the
+    // shared position plus one release store. Capacity is rounded up to a power of two.
+    // from: https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+    template <typename T>
+    class MPMCQueue
+    {
+    public:
+        explicit MPMCQueue(size_t requestedCapacity)
+        {
+            size_t capacity = 2;
+            while (capacity < requestedCapacity)
+            {
+                capacity <<= 1;
+            }
+
+            mask = capacity - 1;
+            cells = std::make_unique<Cell[]>(capacity);
+            for (size_t i = 0; i < capacity; i++)
+            {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~MPMCQueue()
+        {
+            T discarded;
+            while (tryPop(discarded))
+            {
+            }
+        }
+
+        MPMCQueue(const MPMCQueue &) = delete;
+        MPMCQueue &operator=(const MPMCQueue &) = delete;
+
+        // Leaves value untouched and returns false when the queue is full
+        template <typename U>
+        bool tryPush(U &&value)
+        {
+            Cell *cell;
+            size_t position = enqueuePosition.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                cell = &cells[position & mask];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (difference == 0)
+                {
+                    if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            new (cell->storage) T(std::forward<U>(value));
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool tryPop(T &out)
+        {
+            Cell *cell;
+            size_t position = dequeuePosition.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                cell = &cells[position & mask];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+                if (difference == 0)
+                {
+                    if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = dequeuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            T *value = std::launder(reinterpret_cast<T *>(cell->storage));
+            out = std::move(*value);
+            value->~T();
+            cell->sequence.store(position + mask + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t getCapacity() const { return mask + 1; }
+
+        // Only a snapshot, other threads may change it right away
+        size_t getSizeApprox() const
+        {
+            const size_t enqueued = enqueuePosition.load(std::memory_order_relaxed);
+            const size_t dequeued = dequeuePosition.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+    private:
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        std::unique_ptr<Cell[]> cells;
+        size_t mask;
+
+        // Producers and consumers each hammer their own position, keep them on separate lines
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePosition{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePosition{0};
+    };
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace VoxelEngine
+{
+    // Read only memory mapping of a whole file, the pages are loaded on first touch
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        // Returns false when the file is missing, empty or cannot be mapped
+        bool open(const std::filesystem::path &path);
+        void close();
+
+        const uint8_t *getData() const { return data; }
+        size_t getSize() const { return size; }
+
+    private:
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        void *fileHandle = nullptr;
+        void *mappingHandle = nullptr;
+#endif
+    };
+}
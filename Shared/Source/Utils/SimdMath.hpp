@@ -0,0 +1,59 @@
+#pragma once
+
+// SSE helpers for batched math. Everything here is only declared when SSE2 is available,
+// check VOXEL_ENGINE_SSE2 before using it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VOXEL_ENGINE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace VoxelEngine
+{
+#ifdef VOXEL_ENGINE_SSE2
+    // Sine and cosine of four angles at once, accurate to a few ulp for |x| below ~8192.
+    // Reduces to [-pi/4, pi/4] in octants and evaluates the Cephes minimax polynomials.
+    // from: http://gruntthepeon.free.fr/ssemath/ (sse_mathfun, zlib license)
+    inline void sinCos4(__m128 x, __m128 &sinOut, __m128 &cosOut)
+    {
+        const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)));
+
+        __m128 sinSign = _mm_and_ps(x, signMask);
+        x = _mm_andnot_ps(signMask, x);
+
+        // Octant, rounded up to even so the remainder is centred on zero
+        __m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f))); // 4 / pi
+        octant = _mm_add_epi32(octant, _mm_set1_epi32(1));
+        octant = _mm_and_si128(octant, _mm_set1_epi32(~1));
+        const __m128 y = _mm_cvtepi32_ps(octant);
+
+        const __m128 sinSwap = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29));
+        const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+        // Octants 2 and 6 swap the sine and cosine polynomials
+        const __m128 usePolynomialSin = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+        sinSign = _mm_xor_ps(sinSign, sinSwap);
+
+        // x - y * pi / 4 in three parts to keep the precision
+        x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+        const __m128 z = _mm_mul_ps(x, x);
+
+        __m128 cosPolynomial = _mm_set1_ps(2.443315711809948e-5f);
+        cosPolynomial = _mm_add_ps(_mm_mul_ps(cosPolynomial, z), _mm_set1_ps(-1.388731625493765e-3f));
+        cosPolynomial = _mm_add_ps(_mm_mul_ps(cosPolynomial, z), _mm_set1_ps(4.166664568298827e-2f));
+        cosPolynomial = _mm_mul_ps(_mm_mul_ps(cosPolynomial, z), z);
+        cosPolynomial = _mm_sub_ps(cosPolynomial, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+        cosPolynomial = _mm_add_ps(cosPolynomial, _mm_set1_ps(1.f));
+
+        __m128 sinPolynomial = _mm_set1_ps(-1.9515295891e-4f);
+        sinPolynomial = _mm_add_ps(_mm_mul_ps(sinPolynomial, z), _mm_set1_ps(8.3321608736e-3f));
+        sinPolynomial = _mm_add_ps(_mm_mul_ps(sinPolynomial, z), _mm_set1_ps(-1.6666654611e-1f));
+        sinPolynomial = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPolynomial, z), x), x);
+
+        const __m128 sinValue = _mm_or_ps(_mm_and_ps(usePolynomialSin, sinPolynomial), _mm_andnot_ps(usePolynomialSin, cosPolynomial));
+        const __m128 cosValue = _mm_or_ps(_mm_and_ps(usePolynomialSin, cosPolynomial), _mm_andnot_ps(usePolynomialSin, sinPolynomial));
+        sinOut = _mm_xor_ps(sinValue, sinSign);
+        cosOut = _mm_xor_ps(cosValue, cosSign);
+    }
+#endif
+}
@@ -0,0 +1,248 @@
+#include "TlsfHeap.hpp"
+
+// std
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace VoxelEngine
+{
+    TlsfHeap::TlsfHeap(uint64_t size) : size{size}
+    {
+        assert(size > 0 && "Heap size must be positive");
+        for (auto &heads : freeHeads)
+        {
+            heads.fill(INVALID_NODE);
+        }
+        insertFree(createNode(0, size));
+    }
+
+    void TlsfHeap::mapping(uint64_t size, uint32_t &fl, uint32_t &sl)
+    {
+        if (size < SMALL_SIZE)
+        {
+            fl = 0;
+            sl = static_cast<uint32_t>(size / (SMALL_SIZE / SL_COUNT));
+            return;
+        }
+
+        const uint32_t log = static_cast<uint32_t>(std::bit_width(size)) - 1;
+        fl = log - SMALL_LOG + 1;
+        sl = static_cast<uint32_t>(size >> (log - SL_BITS)) & (SL_COUNT - 1);
+    }
+
+    uint32_t TlsfHeap::createNode(uint64_t offset, uint64_t size)
+    {
+        uint32_t index;
+        if (!unusedNodes.empty())
+        {
+            index = unusedNodes.back();
+            unusedNodes.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+        }
+
+        nodes[index] = Node{};
+        nodes[index].offset = offset;
+        nodes[index].size = size;
+        return index;
+    }
+
+    void TlsfHeap::releaseNode(uint32_t node)
+    {
+        unusedNodes.push_back(node);
+    }
+
+    void TlsfHeap::insertFree(uint32_t node)
+    {
+        uint32_t fl, sl;
+        mapping(nodes[node].size, fl, sl);
+
+        Node &n = nodes[node];
+        n.free = true;
+        n.prevFree = INVALID_NODE;
+        n.nextFree = freeHeads[fl][sl];
+        if (n.nextFree != INVALID_NODE)
+        {
+            nodes[n.nextFree].prevFree = node;
+        }
+        freeHeads[fl][sl] = node;
+
+        flBitmap |= 1ull << fl;
+        slBitmaps[fl] |= 1u << sl;
+    }
+
+    void TlsfHeap::removeFree(uint32_t node)
+    {
+        uint32_t fl, sl;
+        mapping(nodes[node].size, fl, sl);
+
+        Node &n = nodes[node];
+        if (n.prevFree != INVALID_NODE)
+        {
+            nodes[n.prevFree].nextFree = n.nextFree;
+        }
+        else
+        {
+            freeHeads[fl][sl] = n.nextFree;
+        }
+        if (n.nextFree != INVALID_NODE)
+        {
+            nodes[n.nextFree].prevFree = n.prevFree;
+        }
+        n.free = false;
+        n.prevFree = n.nextFree = INVALID_NODE;
+
+        if (freeHeads[fl][sl] == INVALID_NODE)
+        {
+            slBitmaps[fl] &= ~(1u << sl);
+            if (slBitmaps[fl] == 0)
+            {
+                flBitmap &= ~(1ull << fl);
+            }
+        }
+    }
+
+    uint32_t TlsfHeap::findFree(uint64_t size) const
+    {
+        // Round up to the next class boundary so any range in the found list is large enough
+        if (size < SMALL_SIZE)
+        {
+            const uint64_t step = SMALL_SIZE / SL_COUNT;
+            size = (size + step - 1) & ~(step - 1);
+        }
+        else
+        {
+            const uint32_t log = static_cast<uint32_t>(std::bit_width(size)) - 1;
+            size += (1ull << (log - SL_BITS)) - 1;
+        }
+
+        uint32_t fl, sl;
+        mapping(size, fl, sl);
+        if (fl >= FL_COUNT)
+        {
+            return INVALID_NODE;
+        }
+
+        uint32_t slMap = slBitmaps[fl] & (~0u << sl);
+        if (slMap == 0)
+        {
+            const uint64_t flMap = fl + 1 < 64 ? flBitmap & (~0ull << (fl + 1)) : 0;
+            if (flMap == 0)
+            {
+                return INVALID_NODE;
+            }
+            fl = static_cast<uint32_t>(std::countr_zero(flMap));
+            slMap = slBitmaps[fl];
+        }
+        sl = static_cast<uint32_t>(std::countr_zero(slMap));
+        return freeHeads[fl][sl];
+    }
+
+    uint32_t TlsfHeap::allocate(uint64_t size, uint64_t alignment, uint64_t &offset)
+    {
+        assert(size > 0 && "Cannot allocate an empty range");
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+        const uint32_t node = findFree(size + alignment - 1);
+        if (node == INVALID_NODE)
+        {
+            return INVALID_NODE;
+        }
+        removeFree(node);
+
+        // Leading padding stays free. The range before a free one is always used, so nothing merges
+        const uint64_t alignedOffset = (nodes[node].offset + alignment - 1) & ~(alignment - 1);
+        const uint64_t padding = alignedOffset - nodes[node].offset;
+        if (padding > 0)
+        {
+            const uint32_t front = createNode(nodes[node].offset, padding);
+            nodes[front].prevPhysical = nodes[node].prevPhysical;
+            nodes[front].nextPhysical = node;
+            if (nodes[front].prevPhysical != INVALID_NODE)
+            {
+                nodes[nodes[front].prevPhysical].nextPhysical = front;
+            }
+            nodes[node].prevPhysical = front;
+            nodes[node].offset = alignedOffset;
+            nodes[node].size -= padding;
+            insertFree(front);
+        }
+
+        if (nodes[node].size > size)
+        {
+            const uint32_t back = createNode(nodes[node].offset + size, nodes[node].size - size);
+            nodes[back].prevPhysical = node;
+            nodes[back].nextPhysical = nodes[node].nextPhysical;
+            if (nodes[back].nextPhysical != INVALID_NODE)
+            {
+                nodes[nodes[back].nextPhysical].prevPhysical = back;
+            }
+            nodes[node].nextPhysical = back;
+            nodes[node].size = size;
+            insertFree(back);
+        }
+
+        usedBytes += size;
+        allocationCount++;
+        offset = alignedOffset;
+        return node;
+    }
+
+    void TlsfHeap::absorb(uint32_t left, uint32_t right)
+    {
+        nodes[left].size += nodes[right].size;
+        nodes[left].nextPhysical = nodes[right].nextPhysical;
+        if (nodes[left].nextPhysical != INVALID_NODE)
+        {
+            nodes[nodes[left].nextPhysical].prevPhysical = left;
+        }
+        releaseNode(right);
+    }
+
+    void TlsfHeap::free(uint32_t node)
+    {
+        assert(node < nodes.size() && !nodes[node].free && "Freeing an invalid or already free range");
+
+        usedBytes -= nodes[node].size;
+        allocationCount--;
+
+        const uint32_t next = nodes[node].nextPhysical;
+        if (next != INVALID_NODE && nodes[next].free)
+        {
+            removeFree(next);
+            absorb(node, next);
+        }
+
+        const uint32_t prev = nodes[node].prevPhysical;
+        if (prev != INVALID_NODE && nodes[prev].free)
+        {
+            removeFree(prev);
+            absorb(prev, node);
+            node = prev;
+        }
+
+        insertFree(node);
+    }
+
+    uint64_t TlsfHeap::getLargestFreeRange() const
+    {
+        if (flBitmap == 0)
+        {
+            return 0;
+        }
+
+        // Only the highest non-empty class can hold the largest range
+        const uint32_t fl = 63 - static_cast<uint32_t>(std::countl_zero(flBitmap));
+        const uint32_t sl = 31 - static_cast<uint32_t>(std::countl_zero(slBitmaps[fl]));
+        uint64_t largest = 0;
+        for (uint32_t node = freeHeads[fl][sl]; node != INVALID_NODE; node = nodes[node].nextFree)
+        {
+            largest = std::max(largest, nodes[node].size);
+        }
+        return largest;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Two-level segregated fit allocator over an abstract range of bytes.
+    //
+    // Only hands out offsets, the memory itself lives elsewhere (a VkDeviceMemory block for the GPU
+    // allocator). Free ranges are bucketed by a first level power of two and SL_COUNT linear second
+    // level steps, with a bitmap per level, so allocate() and free() are O(1) and neighbouring free
+    // ranges are merged right away.
+    // from: http://www.gii.upv.es/tlsf/files/papers/ecrts04_tlsf.pdf
+    class TlsfHeap
+    {
+    public:
+        static constexpr uint32_t INVALID_NODE = UINT32_MAX;
+
+        explicit TlsfHeap(uint64_t size);
+
+        TlsfHeap(const TlsfHeap &) = delete;
+        TlsfHeap &operator=(const TlsfHeap &) = delete;
+
+        // Returns INVALID_NODE when no free range fits, alignment must be a power of two
+        uint32_t allocate(uint64_t size, uint64_t alignment, uint64_t &offset);
+        void free(uint32_t node);
+
+        uint64_t getSize() const { return size; }
+        uint64_t getUsedBytes() const { return usedBytes; }
+        uint64_t getFreeBytes() const { return size - usedBytes; }
+        uint64_t getLargestFreeRange() const;
+        uint32_t getAllocationCount() const { return allocationCount; }
+        bool isEmpty() const { return allocationCount == 0; }
+
+    private:
+        static constexpr uint32_t SL_BITS = 4;
+        static constexpr uint32_t SL_COUNT = 1u << SL_BITS;
+        // Sizes below SMALL_SIZE share first level 0 in SMALL_SIZE / SL_COUNT byte steps
+        static constexpr uint32_t SMALL_LOG = 8;
+        static constexpr uint64_t SMALL_SIZE = 1ull << SMALL_LOG;
+        static constexpr uint32_t FL_COUNT = 64 - SMALL_LOG + 1;
+
+        struct Node
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t prevPhysical = INVALID_NODE;
+            uint32_t nextPhysical = INVALID_NODE;
+            uint32_t prevFree = INVALID_NODE;
+            uint32_t nextFree = INVALID_NODE;
+            bool free = false;
+        };
+
+        static void mapping(uint64_t size, uint32_t &fl, uint32_t &sl);
+
+        uint32_t createNode(uint64_t offset, uint64_t size);
+        void releaseNode(uint32_t node);
+        void insertFree(uint32_t node);
+        void removeFree(uint32_t node);
+        uint32_t findFree(uint64_t size) const;
+        // Merges right into left, both physically adjacent; right is released
+        void absorb(uint32_t left, uint32_t right);
+
+        uint64_t size;
+        uint64_t usedBytes = 0;
+        uint32_t allocationCount = 0;
+
+        std::vector<Node> nodes;
+        std::vector<uint32_t> unusedNodes;
+
+        uint64_t flBitmap = 0;
+        std::array<uint32_t, FL_COUNT> slBitmaps{};
+        std::array<std::array<uint32_t, SL_COUNT>, FL_COUNT> freeHeads;
+    };
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+
+namespace VoxelEngine
+{
+    using BlockId = uint16_t;
+
+    namespace Blocks
+    {
+        constexpr BlockId AIR = 0;
+        constexpr BlockId STONE = 1;
+        constexpr BlockId DIRT = 2;
+        constexpr BlockId GRASS = 3;
+        constexpr BlockId SAND = 4;
+        constexpr BlockId WATER = 5;
+        constexpr BlockId COUNT = 6;
+    }
+
+    inline bool isSolid(BlockId id) { return id != Blocks::AIR; }
+
+    inline glm::vec3 getBlockColor(BlockId id)
+    {
+        switch (id)
+        {
+        case Blocks::STONE: return {0.50f, 0.50f, 0.52f};
+        case Blocks::DIRT:  return {0.45f, 0.31f, 0.18f};
+        case Blocks::GRASS: return {0.30f, 0.62f, 0.22f};
+        case Blocks::SAND:  return {0.86f, 0.80f, 0.55f};
+        case Blocks::WATER: return {0.20f, 0.35f, 0.80f};
+        default:
+            // Unknown ids get a stable but distinct colour
+            return {
+                static_cast<float>((id * 97u) % 255u) / 255.f,
+                static_cast<float>((id * 57u) % 255u) / 255.f,
+                static_cast<float>((id * 31u) % 255u) / 255.f};
+        }
+    }
+}
@@ -0,0 +1,374 @@
+#include "Chunk.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace VoxelEngine
+{
+
+    Chunk::Chunk(BlockId fillId)
+    {
+        resetUniform(fillId);
+    }
+
+    void Chunk::resetUniform(BlockId id)
+    {
+        palette.assign(1, id);
+        paletteRefCounts.assign(1, static_cast<uint16_t>(VOLUME));
+        data.clear();
+        data.shrink_to_fit();
+        bitsPerIndex = 0;
+    }
+
+    void Chunk::setIndex(int voxelIndex, BlockId id)
+    {
+        assert(voxelIndex >= 0 && voxelIndex < VOLUME && "Voxel index out of range");
+
+        if (bitsPerIndex == DIRECT_BITS)
+        {
+            writePaletteIndex(voxelIndex, id);
+            return;
+        }
+
+        const uint32_t oldIndex = bitsPerIndex == 0 ? 0 : readPaletteIndex(voxelIndex);
+        if (palette[oldIndex] == id)
+        {
+            return;
+        }
+
+        // May repack the data (palette indices are preserved) or switch to direct mode
+        const uint32_t newIndex = acquirePaletteEntry(id);
+        if (bitsPerIndex == DIRECT_BITS)
+        {
+            writePaletteIndex(voxelIndex, id);
+            return;
+        }
+
+        paletteRefCounts[oldIndex]--;
+        paletteRefCounts[newIndex]++;
+        writePaletteIndex(voxelIndex, newIndex);
+
+        if (paletteRefCounts[newIndex] == VOLUME)
+        {
+            resetUniform(id);
+        }
+    }
+
+    uint32_t Chunk::acquirePaletteEntry(BlockId id)
+    {
+        uint32_t freeIndex = static_cast<uint32_t>(palette.size());
+        for (uint32_t i = 0; i < palette.size(); i++)
+        {
+            if (palette[i] == id)
+            {
+                return i;
+            }
+            if (paletteRefCounts[i] == 0 && freeIndex == palette.size())
+            {
+                freeIndex = i;
+            }
+        }
+
+        // Reuse a slot whose last voxel was overwritten
+        if (freeIndex < palette.size())
+        {
+            palette[freeIndex] = id;
+            return freeIndex;
+        }
+
+        if (palette.size() >= (size_t{1} << bitsPerIndex))
+        {
+            const uint32_t nextBits = bitsPerIndex == 0 ? 1 : bitsPerIndex * 2;
+            if (nextBits > 8)
+            {
+                repack(DIRECT_BITS);
+                return 0;
+            }
+            repack(nextBits);
+        }
+
+        palette.push_back(id);
+        paletteRefCounts.push_back(0);
+        return static_cast<uint32_t>(palette.size() - 1);
+    }
+
+    void Chunk::repack(uint32_t newBitsPerIndex)
+    {
+        assert(newBitsPerIndex > bitsPerIndex && "Chunk can only grow its index width in place");
+
+        const bool toDirect = newBitsPerIndex == DIRECT_BITS;
+        const uint32_t entriesPerWord = 64 / newBitsPerIndex;
+        std::vector<uint64_t> newData(VOLUME / entriesPerWord, 0);
+
+        for (int word = 0, voxel = 0; word < static_cast<int>(newData.size()); word++)
+        {
+            uint64_t packed = 0;
+            for (uint32_t entry = 0; entry < entriesPerWord; entry++, voxel++)
+            {
+                uint32_t value = bitsPerIndex == 0 ? 0 : readPaletteIndex(voxel);
+                if (toDirect)
+                {
+                    value = palette[value];
+                }
+                packed |= uint64_t{value} << (entry * newBitsPerIndex);
+            }
+            newData[word] = packed;
+        }
+
+        data = std::move(newData);
+        bitsPerIndex = newBitsPerIndex;
+
+        if (toDirect)
+        {
+            palette.clear();
+            palette.shrink_to_fit();
+            paletteRefCounts.clear();
+            paletteRefCounts.shrink_to_fit();
+        }
+    }
+
+    void Chunk::fill(BlockId id)
+    {
+        resetUniform(id);
+    }
+
+    void Chunk::fill(const glm::ivec3 &min, const glm::ivec3 &max, BlockId id)
+    {
+        const glm::ivec3 from = glm::clamp(min, glm::ivec3{0}, glm::ivec3{SIZE});
+        const glm::ivec3 to = glm::clamp(max, glm::ivec3{0}, glm::ivec3{SIZE});
+
+        if (from == glm::ivec3{0} && to == glm::ivec3{SIZE})
+        {
+            resetUniform(id);
+            return;
+        }
+
+        for (int y = from.y; y < to.y; y++)
+        {
+            for (int z = from.z; z < to.z; z++)
+            {
+                const int row = index(0, y, z);
+                for (int x = from.x; x < to.x; x++)
+                {
+                    setIndex(row + x, id);
+                }
+            }
+        }
+    }
+
+    namespace
+    {
+        // Fixed width lets the compiler unroll the per-word loop, decode sits on the meshing hot path
+        template <uint32_t BITS, bool DIRECT>
+        void decodeWords(const std::vector<uint64_t> &data, const BlockId *palette, BlockId *out)
+        {
+            constexpr uint32_t ENTRIES_PER_WORD = 64 / BITS;
+            constexpr uint64_t MASK = (uint64_t{1} << BITS) - 1;
+
+            for (uint64_t word : data)
+            {
+                for (uint32_t entry = 0; entry < ENTRIES_PER_WORD; entry++)
+                {
+                    const uint32_t value = static_cast<uint32_t>(word & MASK);
+                    *out++ = DIRECT ? static_cast<BlockId>(value) : palette[value];
+                    word >>= BITS;
+                }
+            }
+        }
+    }
+
+    void Chunk::decode(BlockId *out) const
+    {
+        switch (bitsPerIndex)
+        {
+        case 0:
+            std::fill(out, out + VOLUME, palette[0]);
+            break;
+        case 1:
+            decodeWords<1, false>(data, palette.data(), out);
+            break;
+        case 2:
+            decodeWords<2, false>(data, palette.data(), out);
+            break;
+        case 4:
+            decodeWords<4, false>(data, palette.data(), out);
+            break;
+        case 8:
+            decodeWords<8, false>(data, palette.data(), out);
+            break;
+        default:
+            decodeWords<DIRECT_BITS, true>(data, nullptr, out);
+            break;
+        }
+    }
+
+    namespace
+    {
+        // lut maps one byte of packed indices to the solidity bits of the voxels it holds
+        template <uint32_t BITS>
+        void decodeSolidWords(const std::vector<uint64_t> &data, const uint8_t *lut, uint32_t *rows)
+        {
+            constexpr uint32_t VOXELS_PER_BYTE = 8 / BITS;
+
+            uint64_t pending = 0;
+            uint32_t pendingBits = 0;
+            for (uint64_t word : data)
+            {
+                for (uint32_t byte = 0; byte < 8; byte++)
+                {
+                    pending |= uint64_t{lut[word & 0xFF]} << pendingBits;
+                    pendingBits += VOXELS_PER_BYTE;
+                    word >>= 8;
+                    if (pendingBits >= 32)
+                    {
+                        *rows++ = static_cast<uint32_t>(pending);
+                        pending >>= 32;
+                        pendingBits -= 32;
+                    }
+                }
+            }
+        }
+    }
+
+    void Chunk::decodeSolidity(uint32_t *rows) const
+    {
+        if (bitsPerIndex == 0)
+        {
+            std::fill(rows, rows + AREA, isSolid(palette[0]) ? ~0u : 0u);
+            return;
+        }
+
+        if (bitsPerIndex == DIRECT_BITS)
+        {
+            for (int row = 0, voxel = 0; row < AREA; row++)
+            {
+                uint32_t bits = 0;
+                for (int x = 0; x < SIZE; x++, voxel++)
+                {
+                    bits |= static_cast<uint32_t>(isSolid(static_cast<BlockId>(readPaletteIndex(voxel)))) << x;
+                }
+                rows[row] = bits;
+            }
+            return;
+        }
+
+        // Translate whole bytes of packed indices at once instead of going voxel by voxel
+        const uint32_t voxelsPerByte = 8 / bitsPerIndex;
+        const uint32_t mask = (1u << bitsPerIndex) - 1;
+        uint8_t lut[256];
+        for (uint32_t byte = 0; byte < 256; byte++)
+        {
+            uint8_t bits = 0;
+            for (uint32_t entry = 0; entry < voxelsPerByte; entry++)
+            {
+                const uint32_t paletteIndex = (byte >> (entry * bitsPerIndex)) & mask;
+                if (paletteIndex < palette.size() && isSolid(palette[paletteIndex]))
+                {
+                    bits |= static_cast<uint8_t>(1u << entry);
+                }
+            }
+            lut[byte] = bits;
+        }
+
+        switch (bitsPerIndex)
+        {
+        case 1:
+            decodeSolidWords<1>(data, lut, rows);
+            break;
+        case 2:
+            decodeSolidWords<2>(data, lut, rows);
+            break;
+        case 4:
+            decodeSolidWords<4>(data, lut, rows);
+            break;
+        default:
+            decodeSolidWords<8>(data, lut, rows);
+            break;
+        }
+    }
+
+    void Chunk::encode(const BlockId *voxels)
+    {
+        std::vector<BlockId> newPalette;
+        std::vector<uint16_t> newRefCounts;
+        std::vector<uint16_t> indices(VOLUME);
+
+        uint32_t lastIndex = 0;
+        for (int i = 0; i < VOLUME; i++)
+        {
+            // Terrain is run-heavy, so checking the previous hit first skips most palette scans
+            if (newPalette.empty() || newPalette[lastIndex] != voxels[i])
+            {
+                auto it = std::find(newPalette.begin(), newPalette.end(), voxels[i]);
+                if (it == newPalette.end())
+                {
+                    if (newPalette.size() == 256)
+                    {
+                        // Too many distinct ids for palette mode, store them directly
+                        palette.clear();
+                        palette.shrink_to_fit();
+                        paletteRefCounts.clear();
+                        paletteRefCounts.shrink_to_fit();
+                        bitsPerIndex = DIRECT_BITS;
+                        data.assign(VOLUME * DIRECT_BITS / 64, 0);
+                        for (int voxel = 0; voxel < VOLUME; voxel++)
+                        {
+                            writePaletteIndex(voxel, voxels[voxel]);
+                        }
+                        return;
+                    }
+                    newPalette.push_back(voxels[i]);
+                    newRefCounts.push_back(0);
+                    it = newPalette.end() - 1;
+                }
+                lastIndex = static_cast<uint32_t>(it - newPalette.begin());
+            }
+            newRefCounts[lastIndex]++;
+            indices[i] = static_cast<uint16_t>(lastIndex);
+        }
+
+        if (newPalette.size() == 1)
+        {
+            resetUniform(newPalette[0]);
+            return;
+        }
+
+        uint32_t newBits = 1;
+        while ((size_t{1} << newBits) < newPalette.size())
+        {
+            newBits *= 2;
+        }
+
+        palette = std::move(newPalette);
+        paletteRefCounts = std::move(newRefCounts);
+        bitsPerIndex = newBits;
+        data.assign(VOLUME * newBits / 64, 0);
+        data.shrink_to_fit();
+
+        for (int i = 0; i < VOLUME; i++)
+        {
+            writePaletteIndex(i, indices[i]);
+        }
+    }
+
+    void Chunk::compact()
+    {
+        if (bitsPerIndex == 0)
+        {
+            return;
+        }
+
+        std::vector<BlockId> voxels(VOLUME);
+        decode(voxels.data());
+        encode(voxels.data());
+    }
+
+    size_t Chunk::getMemoryUsage() const
+    {
+        return sizeof(Chunk) +
+               palette.capacity() * sizeof(BlockId) +
+               paletteRefCounts.capacity() * sizeof(uint16_t) +
+               data.capacity() * sizeof(uint64_t);
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Block.hpp"
+
+// std
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Palette-compressed block storage for a SIZE^3 chunk.
+    //
+    // Every voxel stores an index into a per-chunk palette of block ids. Indices are packed into
+    // 64-bit words using 0, 1, 2, 4, 8 or 16 bits each, growing on demand as new block ids are
+    // written. A uniform chunk (bitsPerIndex == 0) stores no index data at all, and once the
+    // palette would exceed 256 entries the chunk switches to direct mode where the 16-bit words
+    // are the block ids themselves.
+    //
+    // Not thread safe: concurrent readers are fine, writers need external synchronization.
+    class Chunk
+    {
+    public:
+        static constexpr int SIZE = 32;
+        static constexpr int AREA = SIZE * SIZE;
+        static constexpr int VOLUME = SIZE * SIZE * SIZE;
+        static constexpr BlockId AIR = Blocks::AIR;
+
+        explicit Chunk(BlockId fillId = AIR);
+
+        // Voxels are laid out x-fastest, then z, then y
+        static int index(int x, int y, int z) { return x + SIZE * (z + SIZE * y); }
+        static bool inBounds(int x, int y, int z)
+        {
+            return static_cast<unsigned>(x) < SIZE && static_cast<unsigned>(y) < SIZE && static_cast<unsigned>(z) < SIZE;
+        }
+
+        BlockId get(int x, int y, int z) const { return getIndex(index(x, y, z)); }
+        BlockId getIndex(int voxelIndex) const
+        {
+            assert(voxelIndex >= 0 && voxelIndex < VOLUME && "Voxel index out of range");
+
+            if (bitsPerIndex == 0)
+            {
+                return palette[0];
+            }
+
+            const uint32_t value = readPaletteIndex(voxelIndex);
+            return bitsPerIndex == DIRECT_BITS ? static_cast<BlockId>(value) : palette[value];
+        }
+
+        void set(int x, int y, int z, BlockId id) { setIndex(index(x, y, z), id); }
+        void setIndex(int voxelIndex, BlockId id);
+
+        // Fills the whole chunk, dropping the palette back to a single entry
+        void fill(BlockId id);
+        // Fills the box [min, max) clamped to the chunk bounds
+        void fill(const glm::ivec3 &min, const glm::ivec3 &max, BlockId id);
+
+        // Unpacks every voxel into out[VOLUME] using the same layout as index()
+        void decode(BlockId *out) const;
+        // Writes one bit per voxel into rows[AREA]: bit x of rows[y * SIZE + z] is set if the voxel is solid
+        void decodeSolidity(uint32_t *rows) const;
+        // Replaces the contents with voxels[VOLUME], building the smallest palette that fits
+        void encode(const BlockId *voxels);
+
+        // Drops unused palette entries and shrinks the index width if possible
+        void compact();
+
+        bool isUniform() const { return bitsPerIndex == 0; }
+        bool isEmpty() const { return isUniform() && palette[0] == AIR; }
+        uint32_t getBitsPerIndex() const { return bitsPerIndex; }
+        size_t getPaletteSize() const { return palette.size(); }
+
+        // Heap + inline bytes owned by this chunk
+        size_t getMemoryUsage() const;
+
+    private:
+        static constexpr uint32_t DIRECT_BITS = 16;
+
+        uint32_t readPaletteIndex(int voxelIndex) const
+        {
+            const uint32_t bitIndex = static_cast<uint32_t>(voxelIndex) * bitsPerIndex;
+            const uint64_t mask = (uint64_t{1} << bitsPerIndex) - 1;
+            return static_cast<uint32_t>((data[bitIndex >> 6] >> (bitIndex & 63)) & mask);
+        }
+
+        void writePaletteIndex(int voxelIndex, uint32_t paletteIndex)
+        {
+            const uint32_t bitIndex = static_cast<uint32_t>(voxelIndex) * bitsPerIndex;
+            const uint64_t mask = (uint64_t{1} << bitsPerIndex) - 1;
+            uint64_t &word = data[bitIndex >> 6];
+            word = (word & ~(mask << (bitIndex & 63))) | (uint64_t{paletteIndex} << (bitIndex & 63));
+        }
+
+        uint32_t acquirePaletteEntry(BlockId id);
+        void repack(uint32_t newBitsPerIndex);
+        void resetUniform(BlockId id);
+
+        std::vector<BlockId> palette;
+        std::vector<uint16_t> paletteRefCounts;
+        std::vector<uint64_t> data;
+        uint32_t bitsPerIndex = 0;
+    };
+}
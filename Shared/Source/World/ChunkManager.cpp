@@ -0,0 +1,319 @@
+#include "ChunkManager.hpp"
+
+#include "ChunkMesher.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace VoxelEngine
+{
+    namespace
+    {
+        constexpr glm::ivec3 NEIGHBOUR_OFFSETS[ChunkMesher::FACE_COUNT] = {
+            {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    }
+
+    ChunkManager::ChunkManager(Device &device, UploadManager &uploadManager, JobSystem &jobSystem, const TerrainGenerator &generator)
+        : device{device},
+          uploadManager{uploadManager},
+          jobSystem{jobSystem},
+          generator{generator},
+          arena{device, Model::VertexFormat::Packed, ARENA_VERTEX_CAPACITY, ARENA_INDEX_CAPACITY}
+    {
+        bedrock = std::make_shared<Chunk>(Blocks::STONE);
+        setViewRadius(viewRadius);
+    }
+
+    ChunkManager::~ChunkManager()
+    {
+        // Queued jobs still hold a pointer to us, let them run out as no-ops
+        cancelled.store(true, std::memory_order_release);
+        while (activeJobs.load(std::memory_order_acquire) != 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void ChunkManager::setViewRadius(int radius)
+    {
+        viewRadius = std::max(radius, 1);
+
+        // One extra ring is generated so the outermost meshed chunks have all their neighbours
+        const int generationRadius = viewRadius + 1;
+        scheduleOffsets.clear();
+        for (int z = -generationRadius; z <= generationRadius; z++)
+        {
+            for (int x = -generationRadius; x <= generationRadius; x++)
+            {
+                if (x * x + z * z <= generationRadius * generationRadius)
+                {
+                    scheduleOffsets.push_back({x, z});
+                }
+            }
+        }
+        std::sort(scheduleOffsets.begin(), scheduleOffsets.end(), [](const glm::ivec2 &a, const glm::ivec2 &b)
+                  { return a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y; });
+    }
+
+    glm::mat4 ChunkManager::getModelMatrix(const glm::ivec3 &chunkCoord)
+    {
+        // Equivalent to translate(origin with y negated) * scale(1, -1, 1)
+        const glm::vec3 origin = glm::vec3{chunkCoord * Chunk::SIZE};
+        glm::mat4 matrix = getNormalMatrix();
+        matrix[3] = glm::vec4{origin.x, -origin.y, origin.z, 1.f};
+        return matrix;
+    }
+
+    glm::mat4 ChunkManager::getNormalMatrix()
+    {
+        glm::mat4 matrix{1.f};
+        matrix[1][1] = -1.f;
+        return matrix;
+    }
+
+    void ChunkManager::update(const glm::vec3 &viewerPosition)
+    {
+        const glm::ivec3 viewerChunk{
+            static_cast<int>(std::floor(viewerPosition.x / Chunk::SIZE)),
+            static_cast<int>(std::floor(-viewerPosition.y / Chunk::SIZE)),
+            static_cast<int>(std::floor(viewerPosition.z / Chunk::SIZE))};
+
+        drainCompletions();
+        uploadMeshes();
+        unloadDistantChunks(viewerChunk);
+        scheduleJobs(viewerChunk);
+
+        releaseRetiredMeshes();
+    }
+
+    void ChunkManager::drainCompletions()
+    {
+        ChunkResult result;
+        while (completions.tryPop(result))
+        {
+            jobsInFlight--;
+
+            auto it = entries.find(result.coord);
+            if (it == entries.end())
+            {
+                // Unloaded while the job was running
+                continue;
+            }
+
+            ChunkEntry &entry = it->second;
+            if (result.mesh)
+            {
+                if (entry.state == ChunkState::Meshing)
+                {
+                    pendingUploads.emplace_back(result.coord, std::move(result.mesh));
+                }
+            }
+            else if (entry.state == ChunkState::Generating)
+            {
+                entry.chunk = std::move(result.chunk);
+                entry.state = ChunkState::Generated;
+            }
+        }
+    }
+
+    void ChunkManager::uploadMeshes()
+    {
+        for (uint32_t uploads = 0; uploads < maxUploadsPerFrame && !pendingUploads.empty();)
+        {
+            auto &[coord, mesh] = pendingUploads.front();
+
+            auto it = entries.find(coord);
+            if (it == entries.end() || it->second.state != ChunkState::Meshing)
+            {
+                pendingUploads.pop_front();
+                continue;
+            }
+
+            ChunkEntry &entry = it->second;
+            if (!mesh->indices.empty())
+            {
+                // Arena full, retry once retired meshes have been released
+                if (!arena.allocate(*mesh, uploadManager, entry.mesh))
+                {
+                    break;
+                }
+                uploads++;
+            }
+            entry.state = ChunkState::Ready;
+            pendingUploads.pop_front();
+        }
+
+        uploadManager.flush();
+    }
+
+    void ChunkManager::unloadDistantChunks(const glm::ivec3 &viewerChunk)
+    {
+        const int unloadRadius = viewRadius + 2;
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            const int dx = it->first.x - viewerChunk.x;
+            const int dz = it->first.z - viewerChunk.z;
+            if (dx * dx + dz * dz > unloadRadius * unloadRadius)
+            {
+                retireMesh(it->second.mesh);
+                it = entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void ChunkManager::scheduleJobs(const glm::ivec3 &viewerChunk)
+    {
+        for (const glm::ivec2 &offset : scheduleOffsets)
+        {
+            if (jobsInFlight >= maxJobsInFlight)
+            {
+                return;
+            }
+
+            const int distanceSquared = offset.x * offset.x + offset.y * offset.y;
+            const bool meshable = distanceSquared <= viewRadius * viewRadius;
+            const uint32_t priority = getPriority(distanceSquared);
+
+            for (int y = 0; y < CHUNKS_Y && jobsInFlight < maxJobsInFlight; y++)
+            {
+                const glm::ivec3 coord{viewerChunk.x + offset.x, y, viewerChunk.z + offset.y};
+                auto it = entries.find(coord);
+                if (it == entries.end())
+                {
+                    submitGeneration(coord, priority);
+                }
+                else if (meshable && it->second.state == ChunkState::Generated)
+                {
+                    trySubmitMeshing(coord, it->second, priority);
+                }
+            }
+        }
+    }
+
+    uint32_t ChunkManager::getPriority(int distanceSquared) const
+    {
+        const float distance = std::sqrt(static_cast<float>(distanceSquared));
+        const uint32_t level = static_cast<uint32_t>(distance * JobSystem::PRIORITY_LEVELS / (viewRadius + 2));
+        return std::min(level, JobSystem::LOWEST_PRIORITY);
+    }
+
+    void ChunkManager::submitGeneration(const glm::ivec3 &coord, uint32_t priority)
+    {
+        const bool submitted = jobSystem.submit(
+            [this, coord]()
+            {
+                if (!cancelled.load(std::memory_order_acquire))
+                {
+                    auto chunk = std::make_shared<Chunk>();
+                    thread_local std::vector<BlockId> scratch;
+                    generator.generate(coord, *chunk, scratch);
+                    pushResult({coord, std::move(chunk), nullptr});
+                }
+                activeJobs.fetch_sub(1, std::memory_order_release);
+            },
+            priority);
+
+        if (submitted)
+        {
+            activeJobs.fetch_add(1, std::memory_order_relaxed);
+            jobsInFlight++;
+            entries.emplace(coord, ChunkEntry{});
+        }
+    }
+
+    bool ChunkManager::trySubmitMeshing(const glm::ivec3 &coord, ChunkEntry &entry, uint32_t priority)
+    {
+        // Mesh only once every horizontal and vertical neighbour exists so no seams are emitted
+        std::array<std::shared_ptr<const Chunk>, ChunkMesher::FACE_COUNT> neighbours{};
+        for (int face = 0; face < ChunkMesher::FACE_COUNT; face++)
+        {
+            const glm::ivec3 neighbourCoord = coord + NEIGHBOUR_OFFSETS[face];
+            if (neighbourCoord.y < 0)
+            {
+                neighbours[face] = bedrock;
+                continue;
+            }
+            if (neighbourCoord.y >= CHUNKS_Y)
+            {
+                continue;
+            }
+
+            auto it = entries.find(neighbourCoord);
+            if (it == entries.end() || !it->second.chunk)
+            {
+                return false;
+            }
+            neighbours[face] = it->second.chunk;
+        }
+
+        // The job keeps its chunks alive even if they are unloaded before it runs
+        const bool submitted = jobSystem.submit(
+            [this, coord, chunk = entry.chunk, neighbours]()
+            {
+                if (!cancelled.load(std::memory_order_acquire))
+                {
+                    thread_local ChunkMesher mesher;
+                    ChunkMesher::Neighbours neighbourPointers{};
+                    for (int face = 0; face < ChunkMesher::FACE_COUNT; face++)
+                    {
+                        neighbourPointers[face] = neighbours[face].get();
+                    }
+
+                    auto mesh = std::make_unique<Model::Builder>();
+                    mesh->vertexFormat = Model::VertexFormat::Packed;
+                    mesher.mesh(*chunk, neighbourPointers, *mesh);
+                    pushResult({coord, nullptr, std::move(mesh)});
+                }
+                activeJobs.fetch_sub(1, std::memory_order_release);
+            },
+            priority);
+
+        if (submitted)
+        {
+            activeJobs.fetch_add(1, std::memory_order_relaxed);
+            jobsInFlight++;
+            entry.state = ChunkState::Meshing;
+        }
+        return submitted;
+    }
+
+    void ChunkManager::pushResult(ChunkResult &&result)
+    {
+        // Cannot fail while jobsInFlight stays within the queue capacity, but never lose a result
+        while (!completions.tryPush(std::move(result)))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void ChunkManager::retireMesh(MeshArena::Mesh &mesh)
+    {
+        if (mesh.isValid())
+        {
+            // Frames in flight may still draw it, hand it back once they have finished
+            device.deletionQueue().push([releasable = releasableMeshes, mesh]
+                                        { releasable->push_back(mesh); });
+            mesh = MeshArena::Mesh{};
+        }
+    }
+
+    void ChunkManager::releaseRetiredMeshes()
+    {
+        auto released = std::remove_if(releasableMeshes->begin(), releasableMeshes->end(), [&](auto &mesh)
+                                       {
+                                           if (!uploadManager.isComplete(mesh.uploadTicket))
+                                           {
+                                               return false;
+                                           }
+                                           arena.free(mesh);
+                                           return true;
+                                       });
+        releasableMeshes->erase(released, releasableMeshes->end());
+    }
+}
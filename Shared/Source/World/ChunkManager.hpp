@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Chunk.hpp"
+#include "TerrainGenerator.hpp"
+#include "Core/JobSystem.hpp"
+#include "Platform/Device.hpp"
+#include "Platform/MeshArena.hpp"
+#include "Platform/Model.hpp"
+#include "Platform/UploadManager.hpp"
+#include "Utils/MPMCQueue.hpp"
+
+// libs
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Streams terrain chunks around the viewer.
+    //
+    // Generation and meshing run as jobs on the JobSystem, nearest chunks first. Results come back
+    // through a bounded completion queue that update() drains on the render thread, where at most
+    // maxUploadsPerFrame meshes per frame are placed in the MeshArena and handed to the
+    // UploadManager as one batch. A chunk is only drawn once its upload has completed.
+    //
+    // Chunk voxel space is y-up while the engine world is y-down, getModelMatrix() does the flip.
+    class ChunkManager
+    {
+    public:
+        static constexpr int CHUNKS_Y = 2;
+        static constexpr size_t COMPLETION_CAPACITY = 256;
+        // 32 MiB of packed vertices, quads take six indices per four vertices
+        static constexpr uint32_t ARENA_VERTEX_CAPACITY = 4 * 1024 * 1024;
+        static constexpr uint32_t ARENA_INDEX_CAPACITY = ARENA_VERTEX_CAPACITY / 2 * 3;
+
+        ChunkManager(Device &device, UploadManager &uploadManager, JobSystem &jobSystem, const TerrainGenerator &generator);
+        ~ChunkManager();
+
+        ChunkManager(const ChunkManager &) = delete;
+        ChunkManager &operator=(const ChunkManager &) = delete;
+
+        // Call once per frame from the render thread with the viewer position in world space
+        void update(const glm::vec3 &viewerPosition);
+
+        void setViewRadius(int radius);
+        int getViewRadius() const { return viewRadius; }
+        void setMaxUploadsPerFrame(uint32_t uploads) { maxUploadsPerFrame = uploads; }
+
+        static glm::mat4 getModelMatrix(const glm::ivec3 &chunkCoord);
+        static glm::mat4 getNormalMatrix();
+
+        // Every chunk mesh lives in this arena, bind it once before drawing them
+        MeshArena &getArena() { return arena; }
+
+        // Calls function(chunkCoord, mesh) for every chunk with uploaded geometry
+        template <typename Function>
+        void forEachMesh(Function &&function) const
+        {
+            for (const auto &[coord, entry] : entries)
+            {
+                if (entry.mesh.isValid() && uploadManager.isComplete(entry.mesh.uploadTicket))
+                {
+                    function(coord, entry.mesh);
+                }
+            }
+        }
+
+        size_t getLoadedChunkCount() const { return entries.size(); }
+        size_t getPendingUploadCount() const { return pendingUploads.size(); }
+        uint32_t getJobsInFlight() const { return jobsInFlight; }
+
+    private:
+        enum class ChunkState
+        {
+            Generating,
+            Generated,
+            Meshing,
+            Ready
+        };
+
+        struct ChunkEntry
+        {
+            ChunkState state = ChunkState::Generating;
+            std::shared_ptr<const Chunk> chunk;
+            MeshArena::Mesh mesh;
+        };
+
+        // Either a generated chunk or, when mesh is set, the mesh of an already generated one
+        struct ChunkResult
+        {
+            glm::ivec3 coord{};
+            std::shared_ptr<const Chunk> chunk;
+            std::unique_ptr<Model::Builder> mesh;
+        };
+
+        void drainCompletions();
+        void uploadMeshes();
+        void scheduleJobs(const glm::ivec3 &viewerChunk);
+        void unloadDistantChunks(const glm::ivec3 &viewerChunk);
+        void retireMesh(MeshArena::Mesh &mesh);
+        void releaseRetiredMeshes();
+
+        void submitGeneration(const glm::ivec3 &coord, uint32_t priority);
+        bool trySubmitMeshing(const glm::ivec3 &coord, ChunkEntry &entry, uint32_t priority);
+        void pushResult(ChunkResult &&result);
+        uint32_t getPriority(int distanceSquared) const;
+
+        Device &device;
+        UploadManager &uploadManager;
+        JobSystem &jobSystem;
+        const TerrainGenerator &generator;
+        MeshArena arena;
+
+        int viewRadius = 8;
+        // Bounds the staging copies done on the render thread, the GPU side no longer stalls
+        uint32_t maxUploadsPerFrame = 8;
+        // Keeps results waiting in the completion queue below its capacity so workers never block
+        uint32_t maxJobsInFlight = static_cast<uint32_t>(COMPLETION_CAPACITY);
+
+        std::unordered_map<glm::ivec3, ChunkEntry> entries;
+        // Horizontal offsets within viewRadius, nearest first
+        std::vector<glm::ivec2> scheduleOffsets;
+        // Stands in below the world so the bottom layer is not meshed as if floating in air
+        std::shared_ptr<const Chunk> bedrock;
+
+        MPMCQueue<ChunkResult> completions{COMPLETION_CAPACITY};
+        std::deque<std::pair<glm::ivec3, std::unique_ptr<Model::Builder>>> pendingUploads;
+        // Submitted but not yet drained, only touched by the render thread
+        uint32_t jobsInFlight = 0;
+        // Still running on a worker, the destructor waits for these
+        std::atomic<uint32_t> activeJobs{0};
+        std::atomic<bool> cancelled{false};
+
+        // Meshes of unloaded chunks no frame draws anymore, freed once their uploads have finished.
+        // Shared with the deletion queue, whose callbacks may outlive us
+        std::shared_ptr<std::vector<MeshArena::Mesh>> releasableMeshes = std::make_shared<std::vector<MeshArena::Mesh>>();
+    };
+}
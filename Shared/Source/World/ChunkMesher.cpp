@@ -0,0 +1,292 @@
+#include "ChunkMesher.hpp"
+
+// std
+#include <algorithm>
+#include <bit>
+
+namespace VoxelEngine
+{
+    namespace
+    {
+        constexpr int SIZE = Chunk::SIZE;
+        constexpr uint64_t INNER_MASK = 0xFFFFFFFFull;
+
+        // Transposes a 32x32 bit matrix in place: bit j of word i ends up as bit i of word j
+        void transpose32(uint32_t *words)
+        {
+            uint32_t mask = 0x0000FFFFu;
+            for (int shift = 16; shift != 0; shift >>= 1, mask ^= mask << shift)
+            {
+                for (int k = 0; k < 32; k = ((k | shift) + 1) & ~shift)
+                {
+                    const uint32_t t = ((words[k] >> shift) ^ words[k | shift]) & mask;
+                    words[k] ^= t << shift;
+                    words[k | shift] ^= t;
+                }
+            }
+        }
+
+        bool isNeighbourSolid(const Chunk *neighbour, int axis, int depth, int row, int column)
+        {
+            if (neighbour == nullptr)
+            {
+                return false;
+            }
+            // Uniform chunks answer without touching their storage
+            if (neighbour->isUniform())
+            {
+                return isSolid(neighbour->getIndex(0));
+            }
+            const glm::ivec3 p = ChunkMesher::toChunkSpace(axis, depth, row, column);
+            return isSolid(neighbour->get(p.x, p.y, p.z));
+        }
+    }
+
+    void ChunkMesher::generateQuads(const Chunk &chunk, const Neighbours &neighbours)
+    {
+        quads.clear();
+        if (chunk.isEmpty())
+        {
+            return;
+        }
+
+        buildColumns(chunk, neighbours);
+        buildFacePlanes();
+
+        for (int face = 0; face < FACE_COUNT; face++)
+        {
+            for (int depth = 0; depth < SIZE; depth++)
+            {
+                mergePlane(chunk, static_cast<Face>(face), depth);
+            }
+        }
+    }
+
+    void ChunkMesher::mesh(const Chunk &chunk, const Neighbours &neighbours, Model::Builder &builder)
+    {
+        generateQuads(chunk, neighbours);
+        appendQuads(builder);
+    }
+
+    void ChunkMesher::buildColumns(const Chunk &chunk, const Neighbours &neighbours)
+    {
+        // One bit per voxel along x for every (y, z) row
+        chunk.decodeSolidity(solidRows.data());
+
+        // The y and z columns are the same bits transposed, 32x32 at a time
+        std::array<uint32_t, SIZE> block;
+        for (int y = 0; y < SIZE; y++)
+        {
+            for (int z = 0; z < SIZE; z++)
+            {
+                columns[0][y * SIZE + z] = uint64_t{solidRows[y * SIZE + z]} << 1;
+            }
+
+            std::copy_n(&solidRows[y * SIZE], SIZE, block.begin());
+            transpose32(block.data());
+            for (int x = 0; x < SIZE; x++)
+            {
+                columns[2][x * SIZE + y] = uint64_t{block[x]} << 1;
+            }
+        }
+        for (int z = 0; z < SIZE; z++)
+        {
+            for (int y = 0; y < SIZE; y++)
+            {
+                block[y] = solidRows[y * SIZE + z];
+            }
+            transpose32(block.data());
+            for (int x = 0; x < SIZE; x++)
+            {
+                columns[1][z * SIZE + x] = uint64_t{block[x]} << 1;
+            }
+        }
+
+        // Padding bits: bit 0 comes from the negative neighbour, bit SIZE + 1 from the positive one
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const Chunk *positive = neighbours[axis * 2];
+            const Chunk *negative = neighbours[axis * 2 + 1];
+            for (int row = 0; row < SIZE; row++)
+            {
+                for (int column = 0; column < SIZE; column++)
+                {
+                    uint64_t &bits = columns[axis][row * SIZE + column];
+                    if (isNeighbourSolid(negative, axis, SIZE - 1, row, column))
+                    {
+                        bits |= 1;
+                    }
+                    if (isNeighbourSolid(positive, axis, 0, row, column))
+                    {
+                        bits |= uint64_t{1} << (SIZE + 1);
+                    }
+                }
+            }
+        }
+    }
+
+    void ChunkMesher::buildFacePlanes()
+    {
+        for (auto &facePlanes : planes)
+        {
+            for (auto &plane : facePlanes)
+            {
+                plane.fill(0);
+            }
+        }
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            auto &positivePlanes = planes[axis * 2];
+            auto &negativePlanes = planes[axis * 2 + 1];
+            for (int row = 0; row < SIZE; row++)
+            {
+                for (int column = 0; column < SIZE; column++)
+                {
+                    const uint64_t bits = columns[axis][row * SIZE + column];
+                    const uint32_t columnBit = 1u << column;
+
+                    // A face is visible where a solid voxel has air on that side
+                    uint64_t positiveFaces = ((bits & ~(bits >> 1)) >> 1) & INNER_MASK;
+                    uint64_t negativeFaces = ((bits & ~(bits << 1)) >> 1) & INNER_MASK;
+
+                    while (positiveFaces != 0)
+                    {
+                        positivePlanes[std::countr_zero(positiveFaces)][row] |= columnBit;
+                        positiveFaces &= positiveFaces - 1;
+                    }
+                    while (negativeFaces != 0)
+                    {
+                        negativePlanes[std::countr_zero(negativeFaces)][row] |= columnBit;
+                        negativeFaces &= negativeFaces - 1;
+                    }
+                }
+            }
+        }
+    }
+
+    void ChunkMesher::mergePlane(const Chunk &chunk, Face face, int depth)
+    {
+        const int axis = getAxis(face);
+        auto &plane = planes[static_cast<int>(face)][depth];
+
+        for (int row = 0; row < SIZE; row++)
+        {
+            while (plane[row] != 0)
+            {
+                const int column = std::countr_zero(plane[row]);
+                const BlockId block = getVoxel(chunk, axis, depth, row, column);
+
+                // Widen over the run of set bits, stopping at the first block type change
+                const int run = std::countr_zero(~(uint64_t{plane[row]} >> column));
+                int width = 1;
+                while (width < run && getVoxel(chunk, axis, depth, row, column + width) == block)
+                {
+                    width++;
+                }
+
+                const uint32_t mask = static_cast<uint32_t>(((uint64_t{1} << width) - 1) << column);
+                plane[row] &= ~mask;
+
+                // Grow downwards while the next row covers the same span with the same block
+                int height = 1;
+                while (row + height < SIZE && (plane[row + height] & mask) == mask)
+                {
+                    bool sameBlock = true;
+                    for (int c = column; c < column + width && sameBlock; c++)
+                    {
+                        sameBlock = getVoxel(chunk, axis, depth, row + height, c) == block;
+                    }
+                    if (!sameBlock)
+                    {
+                        break;
+                    }
+                    plane[row + height] &= ~mask;
+                    height++;
+                }
+
+                quads.push_back({
+                    static_cast<uint8_t>(depth),
+                    static_cast<uint8_t>(row),
+                    static_cast<uint8_t>(column),
+                    static_cast<uint8_t>(width),
+                    static_cast<uint8_t>(height),
+                    face,
+                    block});
+            }
+        }
+    }
+
+    void ChunkMesher::appendQuads(Model::Builder &builder) const
+    {
+        const bool packed = builder.vertexFormat == Model::VertexFormat::Packed;
+        builder.vertices.clear();
+        builder.packedVertices.clear();
+        builder.indices.clear();
+        if (packed)
+        {
+            builder.packedVertices.reserve(quads.size() * 4);
+        }
+        else
+        {
+            builder.vertices.reserve(quads.size() * 4);
+        }
+        builder.indices.reserve(quads.size() * 6);
+
+        for (uint32_t quadIndex = 0; quadIndex < quads.size(); quadIndex++)
+        {
+            const Quad &quad = quads[quadIndex];
+            const int axis = getAxis(quad.face);
+            const bool positive = isPositive(quad.face);
+            // Positive faces sit on the far side of their voxel
+            const int plane = quad.depth + (positive ? 1 : 0);
+            const glm::vec3 color = getBlockColor(quad.block);
+
+            const int rows[4] = {quad.row, quad.row, quad.row + quad.height, quad.row + quad.height};
+            const int cols[4] = {quad.column, quad.column + quad.width, quad.column + quad.width, quad.column};
+
+            if (packed)
+            {
+                for (int corner = 0; corner < 4; corner++)
+                {
+                    builder.packedVertices.push_back(Model::PackedVertex::pack(
+                        toChunkSpace(axis, plane, rows[corner], cols[corner]),
+                        static_cast<uint32_t>(quad.face),
+                        0,
+                        quad.block,
+                        color));
+                }
+            }
+            else
+            {
+                glm::vec3 normal{0.f};
+                normal[axis] = positive ? 1.f : -1.f;
+                const glm::vec2 uvs[4] = {
+                    {0.f, 0.f},
+                    {static_cast<float>(quad.width), 0.f},
+                    {static_cast<float>(quad.width), static_cast<float>(quad.height)},
+                    {0.f, static_cast<float>(quad.height)}};
+
+                for (int corner = 0; corner < 4; corner++)
+                {
+                    Model::Vertex vertex{};
+                    vertex.position = glm::vec3{toChunkSpace(axis, plane, rows[corner], cols[corner])};
+                    vertex.color = color;
+                    vertex.normal = normal;
+                    vertex.uv = uvs[corner];
+                    builder.vertices.push_back(vertex);
+                }
+            }
+
+            // Corners wind column-then-row, which faces the negative side, so flip positive faces
+            static constexpr uint32_t NEGATIVE_ORDER[6] = {0, 1, 2, 2, 3, 0};
+            static constexpr uint32_t POSITIVE_ORDER[6] = {0, 3, 2, 2, 1, 0};
+            const uint32_t *order = positive ? POSITIVE_ORDER : NEGATIVE_ORDER;
+            const uint32_t base = quadIndex * 4;
+            for (int i = 0; i < 6; i++)
+            {
+                builder.indices.push_back(base + order[i]);
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Chunk.hpp"
+#include "Platform/Model.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Binary greedy mesher: turns a chunk into merged quads.
+    //
+    // Solidity is packed into one 64-bit mask per voxel column along each axis (the 32 chunk voxels
+    // plus one padding bit on each side taken from the neighbour chunks), so visible faces fall out
+    // of a shift and a mask. Faces are then scattered into 32x32 bit planes and merged row by row
+    // with ctz, only joining faces of the same block type.
+    //
+    // Reuses its scratch buffers between calls, so keep one mesher per thread.
+    class ChunkMesher
+    {
+    public:
+        // Ordered so that face / 2 is the axis (x, y, z) and face % 2 is set for the negative side
+        enum class Face : uint8_t
+        {
+            PosX,
+            NegX,
+            PosY,
+            NegY,
+            PosZ,
+            NegZ
+        };
+        static constexpr int FACE_COUNT = 6;
+
+        // Neighbour chunks indexed by Face, nullptr is treated as air
+        using Neighbours = std::array<const Chunk *, FACE_COUNT>;
+
+        // A merged quad in the face's plane space: depth runs along the face axis, row along
+        // (axis + 1) % 3 and column along (axis + 2) % 3. See toChunkSpace().
+        struct Quad
+        {
+            uint8_t depth;
+            uint8_t row;
+            uint8_t column;
+            uint8_t width;  // along column
+            uint8_t height; // along row
+            Face face;
+            BlockId block;
+        };
+
+        ChunkMesher() = default;
+
+        ChunkMesher(const ChunkMesher &) = delete;
+        ChunkMesher &operator=(const ChunkMesher &) = delete;
+
+        // Meshes the chunk into getQuads()
+        void generateQuads(const Chunk &chunk, const Neighbours &neighbours);
+        // Meshes the chunk and replaces the builder contents with chunk-local geometry in
+        // builder.vertexFormat. Packed vertices leave ambient occlusion at 0 for now.
+        void mesh(const Chunk &chunk, const Neighbours &neighbours, Model::Builder &builder);
+
+        const std::vector<Quad> &getQuads() const { return quads; }
+
+        static int getAxis(Face face) { return static_cast<int>(face) >> 1; }
+        static bool isPositive(Face face) { return (static_cast<int>(face) & 1) == 0; }
+        static glm::ivec3 toChunkSpace(int axis, int depth, int row, int column)
+        {
+            glm::ivec3 position{};
+            position[axis] = depth;
+            position[(axis + 1) % 3] = row;
+            position[(axis + 2) % 3] = column;
+            return position;
+        }
+
+    private:
+        void buildColumns(const Chunk &chunk, const Neighbours &neighbours);
+        void buildFacePlanes();
+        void mergePlane(const Chunk &chunk, Face face, int depth);
+        void appendQuads(Model::Builder &builder) const;
+
+        static BlockId getVoxel(const Chunk &chunk, int axis, int depth, int row, int column)
+        {
+            const glm::ivec3 p = toChunkSpace(axis, depth, row, column);
+            return chunk.get(p.x, p.y, p.z);
+        }
+
+        // solidRows[y * SIZE + z], bit x is set for solid voxels
+        std::array<uint32_t, Chunk::AREA> solidRows{};
+        // columns[axis][row * SIZE + column], bit i + 1 is the voxel at depth i
+        std::array<std::array<uint64_t, Chunk::AREA>, 3> columns{};
+        // planes[face][depth][row], bit c is the face at column c
+        std::array<std::array<std::array<uint32_t, Chunk::SIZE>, Chunk::SIZE>, FACE_COUNT> planes{};
+        std::vector<Quad> quads;
+    };
+}
@@ -0,0 +1,122 @@
+#include "TerrainGenerator.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace VoxelEngine
+{
+    namespace
+    {
+        uint32_t hashCoords(int x, int z, uint32_t seed)
+        {
+            uint32_t h = seed ^ (static_cast<uint32_t>(x) * 0x27d4eb2du) ^ (static_cast<uint32_t>(z) * 0x165667b1u);
+            h ^= h >> 15;
+            h *= 0x2c1b3c6du;
+            h ^= h >> 12;
+            h *= 0x297a2d39u;
+            h ^= h >> 15;
+            return h;
+        }
+
+        float smooth(float t) { return t * t * (3.f - 2.f * t); }
+    }
+
+    float TerrainGenerator::valueNoise(float x, float z, uint32_t octaveSeed) const
+    {
+        const float fx = std::floor(x);
+        const float fz = std::floor(z);
+        const int ix = static_cast<int>(fx);
+        const int iz = static_cast<int>(fz);
+        const float tx = smooth(x - fx);
+        const float tz = smooth(z - fz);
+
+        auto corner = [&](int dx, int dz)
+        {
+            return static_cast<float>(hashCoords(ix + dx, iz + dz, octaveSeed) & 0xFFFF) / 65535.f;
+        };
+
+        const float top = corner(0, 0) + (corner(1, 0) - corner(0, 0)) * tx;
+        const float bottom = corner(0, 1) + (corner(1, 1) - corner(0, 1)) * tx;
+        return top + (bottom - top) * tz;
+    }
+
+    int TerrainGenerator::getHeight(int x, int z) const
+    {
+        float height = 0.f;
+        float amplitude = 24.f;
+        float frequency = 1.f / 96.f;
+        for (uint32_t octave = 0; octave < 4; octave++)
+        {
+            height += valueNoise(x * frequency, z * frequency, seed + octave * 7919u) * amplitude;
+            amplitude *= 0.5f;
+            frequency *= 2.f;
+        }
+        return static_cast<int>(height) + 4;
+    }
+
+    void TerrainGenerator::generate(const glm::ivec3 &chunkCoord, Chunk &chunk) const
+    {
+        std::vector<BlockId> scratch;
+        generate(chunkCoord, chunk, scratch);
+    }
+
+    void TerrainGenerator::generate(const glm::ivec3 &chunkCoord, Chunk &chunk, std::vector<BlockId> &scratch) const
+    {
+        const glm::ivec3 origin = chunkCoord * Chunk::SIZE;
+
+        int heights[Chunk::AREA];
+        int maxHeight = 0;
+        int minHeight = 1 << 30;
+        for (int z = 0; z < Chunk::SIZE; z++)
+        {
+            for (int x = 0; x < Chunk::SIZE; x++)
+            {
+                const int height = getHeight(origin.x + x, origin.z + z);
+                heights[z * Chunk::SIZE + x] = height;
+                maxHeight = std::max(maxHeight, height);
+                minHeight = std::min(minHeight, height);
+            }
+        }
+
+        // Chunks entirely above the surface (and the water) or deep below it stay uniform
+        if (origin.y > std::max(maxHeight, SEA_LEVEL))
+        {
+            chunk.fill(Blocks::AIR);
+            return;
+        }
+        if (origin.y + Chunk::SIZE < minHeight - 4)
+        {
+            chunk.fill(Blocks::STONE);
+            return;
+        }
+
+        scratch.resize(Chunk::VOLUME);
+        for (int y = 0; y < Chunk::SIZE; y++)
+        {
+            const int worldY = origin.y + y;
+            for (int z = 0; z < Chunk::SIZE; z++)
+            {
+                for (int x = 0; x < Chunk::SIZE; x++)
+                {
+                    const int height = heights[z * Chunk::SIZE + x];
+                    const bool beach = height <= SEA_LEVEL + 1;
+
+                    BlockId block = Blocks::AIR;
+                    if (worldY < height - 3)
+                        block = Blocks::STONE;
+                    else if (worldY < height - 1)
+                        block = beach ? Blocks::SAND : Blocks::DIRT;
+                    else if (worldY < height)
+                        block = beach ? Blocks::SAND : Blocks::GRASS;
+                    else if (worldY < SEA_LEVEL)
+                        block = Blocks::WATER;
+
+                    scratch[Chunk::index(x, y, z)] = block;
+                }
+            }
+        }
+
+        chunk.encode(scratch.data());
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Chunk.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace VoxelEngine
+{
+    // Heightmap terrain from a few octaves of value noise: stone with a dirt and grass crust,
+    // sand near the water line. Deterministic for a given seed and safe to call from any thread.
+    class TerrainGenerator
+    {
+    public:
+        static constexpr int SEA_LEVEL = 20;
+
+        explicit TerrainGenerator(uint32_t seed = 1337) : seed{seed} {}
+
+        // Surface height in world voxels for the column at (x, z)
+        int getHeight(int x, int z) const;
+
+        // Fills the chunk at chunkCoord (in chunk units) using the given voxel scratch buffer
+        void generate(const glm::ivec3 &chunkCoord, Chunk &chunk, std::vector<BlockId> &scratch) const;
+        void generate(const glm::ivec3 &chunkCoord, Chunk &chunk) const;
+
+    private:
+        float valueNoise(float x, float z, uint32_t octaveSeed) const;
+
+        uint32_t seed;
+    };
+}
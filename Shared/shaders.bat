@@ -5,7 +5,7 @@ set GLSLC="%VULKAN_SDK%\Bin\glslc.exe"
 set SHADER_DIR=..\Game\resources\shaders
 
 echo -- [shaders] Compilando shaders en %SHADER_DIR%
-for %%f in (%SHADER_DIR%\*.vert %SHADER_DIR%\*.frag) do (
+for %%f in (%SHADER_DIR%\*.vert %SHADER_DIR%\*.frag %SHADER_DIR%\*.comp) do (
     set "SOURCE=%%~f"
     set "OUTPUT=%%~f.spv"
     echo -- [shaders] Fuente: !SOURCE!